@@ -1,18 +1,41 @@
 #include "pch.h"
 #include "DbConnection.h"
 #include "encode.h"
+#include "PqPoll.h"
+#include "PqQuote.h"
 #include "DbResult.h"
+#include "PqTypeCatalog.h"
+#include "PqResultCache.h"
+#include "PqRelationCache.h"
+#include "PqUtils.h"
 
 #ifdef _WIN32
 #include <winsock2.h>
 #endif
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef LIBPQ_HAS_ASYNC_CANCEL
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#endif
+
 DbConnection::DbConnection(std::vector<std::string> keys, std::vector<std::string> values,
                            bool check_interrupts) :
   pCurrentResult_(NULL),
   transacting_(false),
+  broken_(false),
   check_interrupts_(check_interrupts),
-  temp_schema_(cpp11::as_sexp(cpp11::r_string(NA_STRING)))
+  interrupt_latency_ms_(50),
+  temp_schema_(cpp11::as_sexp(cpp11::r_string(NA_STRING))),
+  pPool_(NULL)
 {
   size_t n = keys.size();
   std::vector<const char*> c_keys(n + 1), c_values(n + 1);
@@ -32,11 +55,179 @@ DbConnection::DbConnection(std::vector<std::string> keys, std::vector<std::strin
     cpp11::stop(err);
   }
 
-  PQsetClientEncoding(pConn_, "UTF-8");
+  init_connection();
+}
+
+DbConnection::DbConnection(PGconn* pConn, bool check_interrupts) :
+  pConn_(pConn),
+  pCurrentResult_(NULL),
+  transacting_(false),
+  broken_(false),
+  check_interrupts_(check_interrupts),
+  interrupt_latency_ms_(50),
+  temp_schema_(cpp11::as_sexp(cpp11::r_string(NA_STRING))),
+  pPool_(NULL)
+{
+  init_connection();
+}
+
+void DbConnection::init_connection() {
+  // Avoid the round trip if the encoding has been set at startup
+  if (strcmp(pg_encoding_to_char(PQclientEncoding(pConn_)), "UTF8") != 0) {
+    PQsetClientEncoding(pConn_, "UTF-8");
+  }
 
   PQsetNoticeProcessor(pConn_, &process_notice, this);
 }
 
+// Establishes n connections at once: all handshakes are driven
+// by PQconnectPoll() from a single poll loop. Once connected, `init_sql`
+// is sent on each connection (if not empty).
+//
+// On return, `conns[i]` is either a ready connection owned by the caller,
+// or NULL with the reason in `errors[i]`.
+void DbConnection::connect_parallel(const std::vector<std::string>& keys,
+                                    const std::vector<std::string>& values, int n,
+                                    const std::string& init_sql, int timeout_ms,
+                                    std::vector<PGconn*>& conns, std::vector<std::string>& errors) {
+  LOG_DEBUG << n << ", " << timeout_ms;
+
+  typedef std::chrono::steady_clock clock;
+
+  enum ConnectState { CONNECTING, INITIALIZING, DONE };
+
+  size_t nkeys = keys.size();
+  std::vector<const char*> c_keys(nkeys + 1), c_values(nkeys + 1);
+  for (size_t i = 0; i < nkeys; ++i) {
+    c_keys[i] = keys[i].c_str();
+    c_values[i] = values[i].c_str();
+  }
+  c_keys[nkeys] = NULL;
+  c_values[nkeys] = NULL;
+
+  conns.assign(n, NULL);
+  errors.assign(n, std::string());
+  std::vector<ConnectState> state(n, DONE);
+  std::vector<PostgresPollingStatusType> polling(n, PGRES_POLLING_WRITING);
+
+  // Closes connection i and records the error
+  auto fail = [&](int i, const std::string& msg) {
+    errors[i] = msg;
+    PQfinish(conns[i]);
+    conns[i] = NULL;
+    state[i] = DONE;
+  };
+
+  try {
+    int pending = 0;
+    for (int i = 0; i < n; ++i) {
+      conns[i] = PQconnectStartParams(&c_keys[0], &c_values[0], false);
+      if (conns[i] == NULL) {
+        errors[i] = "Out of memory while connecting";
+      } else if (PQstatus(conns[i]) == CONNECTION_BAD) {
+        fail(i, PQerrorMessage(conns[i]));
+      } else {
+        state[i] = CONNECTING;
+        ++pending;
+      }
+    }
+
+    clock::time_point deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    while (pending > 0) {
+      int remaining = -1;
+      if (timeout_ms >= 0) {
+        remaining = static_cast<int>(
+          std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count());
+        if (remaining <= 0) {
+          for (int i = 0; i < n; ++i) {
+            if (state[i] != DONE) {
+              fail(i, "Timed out while connecting");
+            }
+          }
+          break;
+        }
+      }
+
+      std::vector<int> sockets;
+      std::vector<bool> write;
+      std::vector<int> index;
+      for (int i = 0; i < n; ++i) {
+        if (state[i] == DONE) continue;
+        // The socket may change while libpq tries other hosts
+        sockets.push_back(PQsocket(conns[i]));
+        write.push_back(state[i] == CONNECTING && polling[i] == PGRES_POLLING_WRITING);
+        index.push_back(i);
+      }
+
+      std::vector<bool> ready;
+      pq_poll_sockets(sockets, write, ready, remaining);
+
+      for (size_t j = 0; j < index.size(); ++j) {
+        if (!ready[j]) continue;
+
+        int i = index[j];
+        PGconn* pConn = conns[i];
+
+        if (state[i] == CONNECTING) {
+          polling[i] = PQconnectPoll(pConn);
+          if (polling[i] == PGRES_POLLING_FAILED) {
+            fail(i, PQerrorMessage(pConn));
+            --pending;
+          } else if (polling[i] == PGRES_POLLING_OK) {
+            if (init_sql.empty()) {
+              state[i] = DONE;
+              --pending;
+            } else if (!PQsendQuery(pConn, init_sql.c_str())) {
+              fail(i, PQerrorMessage(pConn));
+              --pending;
+            } else {
+              state[i] = INITIALIZING;
+            }
+          }
+          continue;
+        }
+
+        if (!PQconsumeInput(pConn)) {
+          fail(i, PQerrorMessage(pConn));
+          --pending;
+          continue;
+        }
+
+        std::string err;
+        bool finished = false;
+        while (!PQisBusy(pConn)) {
+          PGresult* pRes = PQgetResult(pConn);
+          if (pRes == NULL) {
+            finished = true;
+            break;
+          }
+          if (PQresultStatus(pRes) != PGRES_COMMAND_OK && PQresultStatus(pRes) != PGRES_TUPLES_OK &&
+              err.empty()) {
+            err = PQresultErrorMessage(pRes);
+          }
+          PQclear(pRes);
+        }
+
+        if (finished) {
+          if (err.empty()) {
+            state[i] = DONE;
+          } else {
+            fail(i, err);
+          }
+          --pending;
+        }
+      }
+    }
+  } catch (...) {
+    for (int i = 0; i < n; ++i) {
+      PQfinish(conns[i]);
+      conns[i] = NULL;
+    }
+    throw;
+  }
+}
+
 DbConnection::~DbConnection() {
   LOG_VERBOSE;
   disconnect();
@@ -45,6 +236,10 @@ DbConnection::~DbConnection() {
 void DbConnection::disconnect() {
   try {
     LOG_VERBOSE;
+    // The I/O thread of a prefetching result must not outlive the
+    // connection, the result becomes inactive
+    suspend_current_result();
+    pCurrentResult_ = NULL;
     PQfinish(pConn_);
     LOG_VERBOSE;
     pConn_ = NULL;
@@ -55,7 +250,7 @@ PGconn* DbConnection::conn() {
   return pConn_;
 }
 
-void DbConnection::set_current_result(const DbResult* pResult) {
+void DbConnection::set_current_result(DbResult* pResult) {
   // same result pointer, nothing to do.
   if (pResult == pCurrentResult_)
     return;
@@ -74,7 +269,7 @@ void DbConnection::set_current_result(const DbResult* pResult) {
 }
 
 
-void DbConnection::reset_current_result(const DbResult* pResult) {
+void DbConnection::reset_current_result(DbResult* pResult) {
   // FIXME: inactive result pointer, what to do?
   if (pResult != pCurrentResult_)
     return;
@@ -87,7 +282,96 @@ void DbConnection::reset_current_result(const DbResult* pResult) {
 /**
  * Documentation for canceling queries:
  * https://www.postgresql.org/docs/current/libpq-cancel.html
+ *
+ * The cancel request opens a new connection to the server, which can take
+ * arbitrarily long if the server is unreachable. We give up after
+ * cancel_timeout_ms. Pending results are then discarded for at most
+ * cancel_timeout_ms without data from the server, if the query is still
+ * running after that, the connection is reset instead of waiting for it.
  **/
+static const int cancel_timeout_ms = 5000;
+
+#ifdef LIBPQ_HAS_ASYNC_CANCEL
+
+void DbConnection::cancel_query() {
+  LOG_DEBUG;
+
+  check_connection();
+
+  PGcancelConn* cancel = PQcancelCreate(pConn_);
+  if (cancel == NULL) cpp11::stop(std::string("Connection error detected via PQcancelCreate()"));
+
+  if (!PQcancelStart(cancel)) {
+    std::string msg = PQcancelErrorMessage(cancel);
+    PQcancelFinish(cancel);
+    cpp11::warning(msg);
+    return;
+  }
+
+  std::chrono::steady_clock::time_point deadline =
+    std::chrono::steady_clock::now() + std::chrono::milliseconds(cancel_timeout_ms);
+
+  std::string msg;
+  for (;;) {
+    PostgresPollingStatusType status = PQcancelPoll(cancel);
+    if (status == PGRES_POLLING_OK) {
+      break;
+    }
+    if (status == PGRES_POLLING_FAILED) {
+      msg = PQcancelErrorMessage(cancel);
+      break;
+    }
+
+    int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now()).count());
+    if (remaining <= 0) {
+      msg = "Timed out while canceling query";
+      break;
+    }
+
+    // Don't check for interrupts: we are possibly handling one already
+    std::vector<int> sockets(1, PQcancelSocket(cancel));
+    std::vector<bool> ready;
+    pq_poll_sockets(sockets, ready, remaining, status == PGRES_POLLING_WRITING, 0);
+  }
+
+  PQcancelFinish(cancel);
+
+  if (!msg.empty()) {
+    cpp11::warning(msg);
+  }
+}
+
+#else
+
+// State shared between cancel_query() and the helper thread, the thread
+// may outlive the wait.
+struct PqCancelRequest {
+  std::mutex mutex;
+  std::condition_variable cond;
+  bool done;
+  bool success;
+  char errbuf[256];
+
+  PqCancelRequest() : done(false), success(false) {
+    errbuf[0] = '\0';
+  }
+};
+
+static void pq_cancel_thread(PGcancel* cancel, std::shared_ptr<PqCancelRequest> request) {
+  char errbuf[256];
+  bool success = PQcancel(cancel, errbuf, sizeof(errbuf));
+  PQfreeCancel(cancel);
+
+  std::lock_guard<std::mutex> lock(request->mutex);
+  request->done = true;
+  request->success = success;
+  if (!success) {
+    std::copy(errbuf, errbuf + sizeof(errbuf), request->errbuf);
+  }
+  request->cond.notify_one();
+}
+
 void DbConnection::cancel_query() {
   LOG_DEBUG;
 
@@ -102,16 +386,36 @@ void DbConnection::cancel_query() {
 
   LOG_DEBUG;
 
-  // PQcancel() actually issues the cancel command to the backend.
-  char errbuf[256];
-  if (!PQcancel(cancel, errbuf, sizeof(errbuf))) {
-    cpp11::warning(std::string(errbuf));
+  // PQcancel() blocks, run it in a helper thread that owns the
+  // 'cancel command' data structure.
+  std::shared_ptr<PqCancelRequest> request(new PqCancelRequest);
+  std::thread(pq_cancel_thread, cancel, request).detach();
+
+  std::string msg;
+  {
+    std::unique_lock<std::mutex> lock(request->mutex);
+    std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(cancel_timeout_ms);
+    while (!request->done) {
+      if (request->cond.wait_until(lock, deadline) == std::cv_status::timeout) {
+        break;
+      }
+    }
+
+    if (!request->done) {
+      msg = "Timed out while canceling query";
+    } else if (!request->success) {
+      msg = request->errbuf;
+    }
   }
 
-  // free up the data structure allocated by PQgetCancel().
-  PQfreeCancel(cancel);
+  if (!msg.empty()) {
+    cpp11::warning(msg);
+  }
 }
 
+#endif
+
 void DbConnection::finish_query(PGconn* pConn) {
   // Clear pending results
   PGresult* result;
@@ -120,6 +424,90 @@ void DbConnection::finish_query(PGconn* pConn) {
   }
 }
 
+// Same as above, but gives up if the server sends nothing for `timeout_ms`,
+// e.g. because the cancel request has failed or the network is down.
+// Returns false in that case, results may still be pending.
+bool DbConnection::finish_query(PGconn* pConn, int timeout_ms) {
+  typedef std::chrono::steady_clock clock;
+  clock::time_point deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+
+  for (;;) {
+    // Fails if the connection is broken, PQgetResult() then doesn't block
+    if (!PQconsumeInput(pConn) || PQsocket(pConn) < 0) {
+      finish_query(pConn);
+      return true;
+    }
+
+    while (!PQisBusy(pConn)) {
+      PGresult* result = PQgetResult(pConn);
+      if (result == NULL)
+        return true;
+      PQclear(result);
+    }
+
+    int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - clock::now()).count());
+    if (remaining <= 0)
+      return false;
+
+    // Don't check for interrupts: we are possibly handling one already
+    std::vector<int> sockets(1, PQsocket(pConn));
+    std::vector<bool> ready;
+    if (pq_poll_sockets(sockets, ready, remaining, false, 0) > 0) {
+      deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+    }
+  }
+}
+
+// The query is still running after it has been canceled: closes the
+// connection instead of waiting, and reconnects for at most
+// cancel_timeout_ms. If that doesn't succeed, the connection is marked as
+// broken and reconnected on the next use. The session state is lost.
+void DbConnection::abandon_query() {
+  LOG_DEBUG;
+
+  cpp11::warning(std::string("The query could not be canceled, the connection is reset"));
+  transacting_ = false;
+
+  broken_ = !(PQresetStart(pConn_) && poll_reset(pConn_, cancel_timeout_ms));
+  LOG_DEBUG << broken_;
+}
+
+// Drives a reset started with PQresetStart() until the connection is
+// established, or until timeout_ms have passed. Returns true on success.
+bool DbConnection::poll_reset(PGconn* pConn, int timeout_ms) {
+  typedef std::chrono::steady_clock clock;
+  clock::time_point deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+
+  // Waiting for the socket to become writable comes first
+  PostgresPollingStatusType status = PGRES_POLLING_WRITING;
+  for (;;) {
+    int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - clock::now()).count());
+    if (remaining <= 0)
+      return false;
+
+    // Don't check for interrupts: we are possibly handling one already
+    std::vector<int> sockets(1, PQsocket(pConn));
+    std::vector<bool> ready;
+    pq_poll_sockets(sockets, ready, remaining, status == PGRES_POLLING_WRITING, 0);
+
+    status = PQresetPoll(pConn);
+    if (status == PGRES_POLLING_OK)
+      return true;
+    if (status == PGRES_POLLING_FAILED)
+      return false;
+  }
+}
+
+// Stops background activity of the current result before the connection
+// is used directly
+void DbConnection::suspend_current_result() {
+  if (pCurrentResult_ != NULL) {
+    pCurrentResult_->suspend();
+  }
+}
+
 bool DbConnection::is_current_result(const DbResult* pResult) {
   return pCurrentResult_ == pResult;
 }
@@ -128,6 +516,10 @@ bool DbConnection::has_query() {
   return pCurrentResult_ != NULL;
 }
 
+// `sql` may contain further statements before and after the COPY, they are
+// sent together with it in a single query string. This saves round trips
+// for the statements that prepare and finish the load. The server stops
+// at the first statement that fails.
 void DbConnection::copy_data(std::string sql, cpp11::list df) {
   LOG_DEBUG << sql;
 
@@ -135,12 +527,27 @@ void DbConnection::copy_data(std::string sql, cpp11::list df) {
   if (p == 0)
     return;
 
-  PGresult* pInit = PQexec(pConn_, sql.c_str());
-  if (PQresultStatus(pInit) != PGRES_COPY_IN) {
-    PQclear(pInit);
+  suspend_current_result();
+
+  if (!PQsendQuery(pConn_, sql.c_str())) {
     conn_stop("Failed to initialise COPY");
   }
-  PQclear(pInit);
+
+  for (;;) {
+    PGresult* pInit = PQgetResult(pConn_);
+    ExecStatusType status = PQresultStatus(pInit);
+    if (status == PGRES_COPY_IN) {
+      PQclear(pInit);
+      break;
+    }
+
+    command_done(pInit);
+    PQclear(pInit);
+    if (pInit == NULL || status == PGRES_FATAL_ERROR) {
+      finish_query(pConn_);
+      conn_stop("Failed to initialise COPY");
+    }
+  }
 
 
   std::string buffer;
@@ -161,26 +568,454 @@ void DbConnection::copy_data(std::string sql, cpp11::list df) {
     conn_stop("Failed to finish COPY");
   }
 
-  PGresult* pComplete = PQgetResult(pConn_);
-  if (PQresultStatus(pComplete) != PGRES_COMMAND_OK) {
+  bool failed = false;
+  PGresult* pComplete;
+  while ((pComplete = PQgetResult(pConn_)) != NULL) {
+    if (PQresultStatus(pComplete) != PGRES_COMMAND_OK) {
+      failed = true;
+    }
+    command_done(pComplete);
+    PQclear(pComplete);
+  }
+
+  if (failed) {
+    conn_stop("COPY returned error");
+  }
+}
+
+// Runs a COPY ... TO STDOUT statement and appends the data to a local file
+// as it arrives, one row at a time, so that results of any size can be
+// exported with constant memory. Returns the number of rows.
+double DbConnection::copy_to_file(const std::string& sql, const std::string& path) {
+  LOG_DEBUG << sql;
+
+  suspend_current_result();
+
+  FILE* file = open_file(path, "wb");
+  FileCloser closer(file);
+
+  if (!PQsendQuery(pConn_, sql.c_str())) {
+    conn_stop("Failed to initialise COPY");
+  }
+
+  while (PQisBusy(pConn_)) {
+    wait_for_input();
+  }
+
+  PGresult* pInit = PQgetResult(pConn_);
+  ExecStatusType status = PQresultStatus(pInit);
+  PQclear(pInit);
+  if (status != PGRES_COPY_OUT) {
+    finish_query(pConn_);
+    conn_stop("Failed to initialise COPY");
+  }
+
+  for (;;) {
+    char* buf = NULL;
+    int len = PQgetCopyData(pConn_, &buf, 1);
+
+    if (len > 0) {
+      size_t written = fwrite(buf, 1, len, file);
+      PQfreemem(buf);
+      if (written != static_cast<size_t>(len)) {
+        cancel_copy_out();
+        cpp11::stop("Failed to write to file '%s': %s", path.c_str(), strerror(errno));
+      }
+    } else if (len == 0) {
+      wait_for_input();
+    } else {
+      break;
+    }
+  }
+
+  bool failed = false;
+  double rows = 0;
+  PGresult* pComplete;
+  while ((pComplete = PQgetResult(pConn_)) != NULL) {
+    if (PQresultStatus(pComplete) == PGRES_COMMAND_OK) {
+      rows = atof(PQcmdTuples(pComplete));
+    } else {
+      failed = true;
+    }
     PQclear(pComplete);
+  }
+
+  if (failed) {
     conn_stop("COPY returned error");
   }
-  PQclear(pComplete);
 
+  if (closer.close() != 0)
+    cpp11::stop("Failed to write to file '%s': %s", path.c_str(), strerror(errno));
+
+  return rows;
+}
+
+// Inserts the rows of the data frame with multi-row INSERT statements.
+// `prefix` is the statement up to and including VALUES. Rows are added to
+// a statement as long as it stays below `batch_bytes`, each statement
+// contains at least one row.
+//
+// With pipelining, all statements are sent without waiting for their
+// results, and run in a single implicit transaction. Otherwise, the
+// statements are executed one by one, in a new transaction unless one
+// is open already.
+void DbConnection::insert_values(const std::string& prefix, const cpp11::list& df, bool redshift,
+                                 size_t batch_bytes) {
+  LOG_DEBUG << prefix;
+
+  R_xlen_t p = df.size();
+  if (p == 0)
+    return;
+
+  suspend_current_result();
+
+  R_xlen_t n = Rf_xlength(df[0]);
+  if (n == 0)
+    return;
+
+  // Check everything upfront, generating the statements must not fail
+  std::vector<SEXP> cols(p);
+  std::vector<PqLiteralKind> kinds(p);
+  for (R_xlen_t j = 0; j < p; ++j) {
+    cols[j] = df[j];
+    kinds[j] = PqQuoter::literal_kind(cols[j]);
+    if (kinds[j] == LIT_BLOB) {
+      for (R_xlen_t i = 0; i < n; ++i) {
+        SEXP value = VECTOR_ELT(cols[j], i);
+        if (!Rf_isNull(value) && TYPEOF(value) != RAWSXP)
+          cpp11::stop("Lists must contain raw vectors or NULL");
+      }
+    }
+  }
+
+  PqQuoter quoter(pConn_, redshift);
+  std::string sql;
+  R_xlen_t i = 0;
+
+  // Fills `sql` with the next statement, returns false after the last row
+  auto next_statement = [&]() {
+    if (i >= n)
+      return false;
+
+    sql = prefix;
+    size_t rows = 0;
+    for (; i < n; ++i) {
+      quoter.clear();
+      quoter.append_sql(rows == 0 ? "(" : ",(");
+      for (R_xlen_t j = 0; j < p; ++j) {
+        if (j > 0)
+          quoter.append_sql(",");
+        quoter.append_literal(cols[j], kinds[j], i);
+      }
+      quoter.append_sql(")");
+
+      const std::string& row = quoter.sql();
+      if (rows > 0 && sql.size() + row.size() > batch_bytes)
+        break;
+
+      sql += row;
+      ++rows;
+    }
+    return true;
+  };
+
+#ifdef LIBPQ_HAS_PIPELINING
+  if (!PQenterPipelineMode(pConn_)) {
+    conn_stop("Failed to enter pipeline mode");
+  }
+
+  std::string err;
+  int sent = 0;
+  while (next_statement()) {
+    if (!PQsendQueryParams(pConn_, sql.c_str(), 0, NULL, NULL, NULL, NULL, 0)) {
+      err = PQerrorMessage(pConn_);
+      break;
+    }
+    ++sent;
+
+    // Drain the results that have arrived so far,
+    // so that the server doesn't block on a full send buffer
+    PQconsumeInput(pConn_);
+  }
+
+  PQpipelineSync(pConn_);
+
+  // One group of results for each statement, followed by the sync.
+  // Statements after a failed one are reported as aborted.
+  for (int k = 0; k <= sent; ++k) {
+    PGresult* pRes;
+    while ((pRes = PQgetResult(pConn_)) != NULL) {
+      ExecStatusType status = PQresultStatus(pRes);
+      if (status == PGRES_FATAL_ERROR && err.empty()) {
+        err = PQresultErrorMessage(pRes);
+      }
+      PQclear(pRes);
+      if (status == PGRES_PIPELINE_SYNC)
+        break;
+    }
+  }
+
+  PQexitPipelineMode(pConn_);
+
+  if (!err.empty()) {
+    cpp11::stop("Failed to insert rows : %s", err.c_str());
+  }
+#else
+  bool own_transaction = (PQtransactionStatus(pConn_) == PQTRANS_IDLE);
+  if (own_transaction) {
+    exec("BEGIN");
+  }
+
+  while (next_statement()) {
+    PGresult* pRes = PQexec(pConn_, sql.c_str());
+    ExecStatusType status = PQresultStatus(pRes);
+    PQclear(pRes);
+
+    if (status != PGRES_COMMAND_OK) {
+      std::string err = PQerrorMessage(pConn_);
+      if (own_transaction) {
+        PQclear(PQexec(pConn_, "ROLLBACK"));
+      }
+      cpp11::stop("Failed to insert rows : %s", err.c_str());
+    }
+  }
+
+  if (own_transaction) {
+    exec("COMMIT");
+  }
+#endif
+}
+
+// Streams a row slice of the data frame through COPY on each of the
+// connections. The connections are switched to nonblocking mode, so that
+// a connection with a full send buffer doesn't hold up the others.
+void DbConnection::copy_data_parallel(const std::vector<DbConnection*>& conns, const std::string& sql,
+                                      const cpp11::list& df) {
+  LOG_DEBUG << sql << ", " << conns.size();
+
+  const size_t chunk_size = 65536;
+
+  R_xlen_t p = df.size();
+  if (p == 0 || conns.empty())
+    return;
+
+  struct CopyStream {
+    PGconn* pConn;
+    int next;
+    int end;
+    std::string buffer;
+    bool started;
+    bool ended;
+    bool done;
+  };
+
+  const int n = Rf_length(df[0]);
+  const size_t k = conns.size();
+
+  std::vector<CopyStream> streams(k);
+  for (size_t i = 0; i < k; ++i) {
+    conns[i]->check_connection();
+    CopyStream& s = streams[i];
+    s.pConn = conns[i]->conn();
+    s.next = static_cast<int>(static_cast<double>(n) * i / k);
+    s.end = static_cast<int>(static_cast<double>(n) * (i + 1) / k);
+    s.started = false;
+    s.ended = false;
+    s.done = false;
+  }
+
+  try {
+    // Send all COPY statements before waiting for the first response
+    for (size_t i = 0; i < k; ++i) {
+      if (!PQsendQuery(streams[i].pConn, sql.c_str())) {
+        conn_stop(streams[i].pConn, "Failed to initialise COPY");
+      }
+    }
+
+    for (size_t i = 0; i < k; ++i) {
+      PGresult* pInit = PQgetResult(streams[i].pConn);
+      if (PQresultStatus(pInit) != PGRES_COPY_IN) {
+        PQclear(pInit);
+        conn_stop(streams[i].pConn, "Failed to initialise COPY");
+      }
+      PQclear(pInit);
+      streams[i].started = true;
+
+      if (PQsetnonblocking(streams[i].pConn, 1) != 0) {
+        conn_stop(streams[i].pConn, "Failed to set nonblocking mode");
+      }
+    }
+
+    size_t active = k;
+    while (active > 0) {
+      bool progress = false;
+      std::vector<int> sockets;
+
+      for (size_t i = 0; i < k; ++i) {
+        CopyStream& s = streams[i];
+        if (s.done)
+          continue;
+
+        if (s.buffer.empty()) {
+          while (s.next < s.end && s.buffer.size() < chunk_size) {
+            encode_row_in_buffer(df, s.next++, s.buffer);
+          }
+        }
+
+        if (!s.buffer.empty()) {
+          int ret = PQputCopyData(s.pConn, s.buffer.data(), static_cast<int>(s.buffer.size()));
+          if (ret < 0) {
+            conn_stop(s.pConn, "Failed to put data");
+          }
+          if (ret == 1) {
+            s.buffer.clear();
+            progress = true;
+          }
+        }
+
+        if (s.buffer.empty() && s.next >= s.end && !s.ended) {
+          int ret = PQputCopyEnd(s.pConn, NULL);
+          if (ret < 0) {
+            conn_stop(s.pConn, "Failed to finish COPY");
+          }
+          if (ret == 1) {
+            s.ended = true;
+            progress = true;
+          }
+        }
+
+        int flushed = PQflush(s.pConn);
+        if (flushed < 0) {
+          conn_stop(s.pConn, "Failed to send data");
+        }
+
+        if (s.ended && flushed == 0) {
+          s.done = true;
+          --active;
+          continue;
+        }
+
+        if (flushed == 1) {
+          sockets.push_back(PQsocket(s.pConn));
+        }
+      }
+
+      if (!progress && !sockets.empty()) {
+        std::vector<bool> ready;
+        pq_poll_sockets(sockets, ready, -1, true);
+      }
+    }
+
+    for (size_t i = 0; i < k; ++i) {
+      PQsetnonblocking(streams[i].pConn, 0);
+    }
+
+    for (size_t i = 0; i < k; ++i) {
+      PGresult* pComplete = PQgetResult(streams[i].pConn);
+      if (PQresultStatus(pComplete) != PGRES_COMMAND_OK) {
+        PQclear(pComplete);
+        conn_stop(streams[i].pConn, "COPY returned error");
+      }
+      PQclear(pComplete);
+
+      finish_query(streams[i].pConn);
+    }
+  } catch (...) {
+    // Abort the remaining streams, the server discards their data
+    for (size_t i = 0; i < k; ++i) {
+      PQsetnonblocking(streams[i].pConn, 0);
+      if (streams[i].started && !streams[i].ended) {
+        PQputCopyEnd(streams[i].pConn, "Aborted");
+      }
+      finish_query(streams[i].pConn);
+    }
+    throw;
+  }
+}
+
+void DbConnection::exec(const std::string& sql) {
+  LOG_DEBUG << sql;
+
+  suspend_current_result();
+
+  PGresult* pRes = PQexec(pConn_, sql.c_str());
+  ExecStatusType status = PQresultStatus(pRes);
+  command_done(pRes);
+  PQclear(pRes);
+
+  if (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK && status != PGRES_EMPTY_QUERY) {
+    conn_stop("Failed to execute statement");
+  }
+}
+
+// Waits until data from the server has arrived, checking user interrupts
+// if enabled. An interrupt cancels the running COPY.
+void DbConnection::wait_for_input() {
+  std::vector<int> sockets(1, PQsocket(pConn_));
+  std::vector<bool> ready;
+  try {
+    pq_poll_sockets(sockets, ready, -1, false, check_interrupts_ ? interrupt_latency_ms_ : 0);
+  }
+  catch (...) {
+    LOG_DEBUG;
+    cancel_copy_out();
+    throw;
+  }
+
+  if (!PQconsumeInput(pConn_)) {
+    conn_stop("Failed to consume input from the server");
+  }
+}
+
+// Cancels a COPY ... TO STDOUT, and discards the data that has been
+// sent until the server has stopped
+void DbConnection::cancel_copy_out() {
+  cancel_query();
+
+  char* buf = NULL;
+  while (PQgetCopyData(pConn_, &buf, 0) > 0) {
+    PQfreemem(buf);
+  }
   finish_query(pConn_);
 }
 
+// Runs `fun` in the current transaction, or in a new one that is committed
+// afterwards and rolled back on error
+void DbConnection::with_transaction(const std::function<void()>& fun) {
+  check_connection();
+  suspend_current_result();
+
+  bool own = (PQtransactionStatus(pConn_) == PQTRANS_IDLE);
+  if (own) {
+    exec("BEGIN");
+  }
+
+  try {
+    fun();
+  } catch (...) {
+    if (own) {
+      PGresult* pRes = PQexec(pConn_, "ROLLBACK");
+      PQclear(pRes);
+    }
+    throw;
+  }
+
+  if (own) {
+    exec("COMMIT");
+  }
+}
+
 void DbConnection::check_connection() {
   if (!pConn_) {
     cpp11::stop(std::string("Disconnected"));
   }
 
   ConnStatusType status = PQstatus(pConn_);
-  if (status == CONNECTION_OK) return;
+  if (status == CONNECTION_OK && !broken_) return;
 
   // Status was bad, so try resetting.
   PQreset(pConn_);
+  broken_ = false;
   status = PQstatus(pConn_);
   if (status == CONNECTION_OK) return;
 
@@ -211,40 +1046,101 @@ cpp11::list DbConnection::info() {
     });
 }
 
-bool DbConnection::is_check_interrupts() const {
-  return check_interrupts_;
+// Options in effect for the connection, e.g. to open further connections
+// to the same server
+cpp11::strings DbConnection::conninfo() {
+  check_connection();
+
+  PQconninfoOption* opts = PQconninfo(pConn_);
+  if (opts == NULL)
+    cpp11::stop("Failed to retrieve connection options");
+
+  std::vector<std::string> keys, values;
+  for (PQconninfoOption* opt = opts; opt->keyword != NULL; ++opt) {
+    if (opt->val == NULL)
+      continue;
+    keys.push_back(opt->keyword);
+    values.push_back(opt->val);
+  }
+  PQconninfoFree(opts);
+
+  cpp11::writable::strings out(cpp11::as_sexp(values));
+  out.attr("names") = cpp11::as_sexp(keys);
+  return out;
 }
 
-SEXP DbConnection::quote_string(const cpp11::r_string& x) {
-  // Returns a single CHRSXP
+cpp11::strings DbConnection::typnames(const std::vector<double>& oids) {
   check_connection();
 
-  if (x == NA_STRING)
-    return get_null_string();
+  // Called between dbFetch() calls, the lookup may use the connection
+  suspend_current_result();
+
+  std::vector<Oid> c_oids(oids.size());
+  for (size_t i = 0; i < oids.size(); ++i) {
+    c_oids[i] = static_cast<Oid>(oids[i]);
+  }
+
+  resolve_types(c_oids);
+
+  cpp11::writable::strings out(oids.size());
+  for (size_t i = 0; i < c_oids.size(); ++i) {
+    const PqTypeInfo* info = pCatalog_ ? pCatalog_->find(c_oids[i]) : NULL;
+    if (info == NULL) {
+      out[i] = NA_STRING;
+    } else {
+      out[i] = info->typname;
+    }
+  }
+  return out;
+}
+
+// Adds the types that aren't known yet to the shared catalog. The lookup
+// runs on this connection and sees the types of the current transaction,
+// it is skipped while a query is running, e.g. while rows are streamed,
+// and the types remain unknown for now.
+void DbConnection::resolve_types(const std::vector<Oid>& oids) {
+  PGTransactionStatusType status = PQtransactionStatus(pConn_);
+  if (status != PQTRANS_IDLE && status != PQTRANS_INTRANS) {
+    LOG_DEBUG << status;
+    return;
+  }
+
+  if (!pCatalog_) {
+    pCatalog_ = PqTypeCatalog::get(pConn_);
+  }
 
-  const auto str = static_cast<std::string>(x);
-  char* pq_escaped = PQescapeLiteral(pConn_, str.c_str(), static_cast<size_t>(-1));
-  auto escaped = Rf_mkCharCE(pq_escaped, CE_UTF8);
-  PQfreemem(pq_escaped);
+  std::vector<Oid> missing = pCatalog_->missing(oids);
+  if (!missing.empty()) {
+    pCatalog_->fetch(pConn_, missing);
+  }
+}
 
-  return escaped;
+bool DbConnection::has_typname(Oid oid) const {
+  return pCatalog_ && pCatalog_->find(oid) != NULL;
 }
 
-SEXP DbConnection::quote_identifier(const cpp11::r_string& x) {
-  // Returns a single CHRSXP
+cpp11::strings DbConnection::parameter_status(const std::string& name) {
   check_connection();
 
-  const auto str = static_cast<std::string>(x);
-  char* pq_escaped = PQescapeIdentifier(pConn_, str.c_str(), static_cast<size_t>(-1));
-  auto escaped = Rf_mkCharCE(pq_escaped, CE_UTF8);
-  PQfreemem(pq_escaped);
+  const char* value = PQparameterStatus(pConn_, name.c_str());
+  if (value == NULL) {
+    return cpp11::as_sexp(cpp11::r_string(NA_STRING));
+  }
+  return cpp11::as_sexp(value);
+}
+
+bool DbConnection::is_check_interrupts() const {
+  return check_interrupts_;
+}
 
-  return escaped;
+int DbConnection::get_interrupt_latency() const {
+  return interrupt_latency_ms_;
 }
 
-SEXP DbConnection::get_null_string() {
-  static cpp11::sexp null = Rf_mkCharCE("NULL", CE_UTF8);
-  return null;
+void DbConnection::set_interrupt_latency(int latency_ms) {
+  if (latency_ms < 1)
+    latency_ms = 1;
+  interrupt_latency_ms_ = latency_ms;
 }
 
 bool DbConnection::is_transacting() const {
@@ -263,6 +1159,14 @@ void DbConnection::set_temp_schema(cpp11::strings temp_schema) {
   temp_schema_ = temp_schema;
 }
 
+DbConnectionPool* DbConnection::get_pool() const {
+  return pPool_;
+}
+
+void DbConnection::set_pool(DbConnectionPool* pPool) {
+  pPool_ = pPool;
+}
+
 void DbConnection::conn_stop(const char* msg) {
   conn_stop(conn(), msg);
 }
@@ -276,51 +1180,176 @@ void DbConnection::cleanup_query() {
     return;
   }
 
+  // Gives the result a chance to end server-side state, e.g. a cursor
+  if (pCurrentResult_ != NULL) {
+    pCurrentResult_->close();
+  }
+
   if (pCurrentResult_ != NULL && !(pCurrentResult_->complete())) {
     cancel_query();
   }
-  finish_query(pConn_);
+  if (!finish_query(pConn_, cancel_timeout_ms)) {
+    abandon_query();
+  }
 }
 
 cpp11::list DbConnection::wait_for_notify(int timeout_secs) {
   using namespace cpp11::literals;
-  PGnotify   *notify;
-  cpp11::writable::list out;
-  int socket = -1;
-  fd_set input;
-
-  while (TRUE) {
-    // See if there's a notification waiting, if so return it
-    if (!PQconsumeInput(pConn_)) {
-      cpp11::stop("Failed to consume input from the server");
-    }
-    if ((notify = PQnotifies(pConn_)) != NULL) {
-      out = cpp11::list({
-        "channel"_nm = cpp11::writable::strings({notify->relname}),
-        "pid"_nm = cpp11::writable::integers({notify->be_pid}),
-        "payload"_nm = cpp11::writable::strings({notify->extra})
-      });
-      PQfreemem(notify);
-      return out;
-    }
-
-    if (socket != -1) {
-      // Socket open, so already been round once, give up.
+
+  std::vector<PqNotification> notifications;
+
+  if (consume_notifications() == 0) {
+    // Wait for new data for at most (timeout_secs) seconds, the milliseconds
+    // don't fit into an int for timeouts of more than 24 days
+    int timeout_ms = -1;
+    if (timeout_secs >= 0) {
+      timeout_ms = static_cast<int>(std::min<int64_t>(static_cast<int64_t>(timeout_secs) * 1000, INT_MAX));
+    }
+    std::vector<int> sockets(1, PQsocket(pConn_));
+    std::vector<bool> ready;
+    if (pq_poll_sockets(sockets, ready, timeout_ms) == 0) {
       return cpp11::list();
     }
 
-    // Open DB socket and wait for new data for at most (timeout_secs) seconds
-    if ((socket = PQsocket(pConn_)) < 0) {
-      cpp11::stop("Failed to get connection socket");
+    consume_notifications();
+  }
+
+  take_notifications(notifications, 1);
+  if (notifications.empty()) {
+    return cpp11::list();
+  }
+
+  const PqNotification& notify = notifications[0];
+  return cpp11::list({
+    "channel"_nm = cpp11::writable::strings({notify.channel}),
+    "pid"_nm = cpp11::writable::integers({notify.pid}),
+    "payload"_nm = cpp11::writable::strings({notify.payload})
+  });
+}
+
+// Moves all notifications received by libpq to the queue,
+// returns the number of queued notifications
+size_t DbConnection::consume_notifications() {
+  check_connection();
+  suspend_current_result();
+
+  if (!PQconsumeInput(pConn_)) {
+    conn_stop("Failed to consume input from the server");
+  }
+
+  PGnotify* notify;
+  while ((notify = PQnotifies(pConn_)) != NULL) {
+    PqNotification item;
+    item.channel = notify->relname;
+    item.pid = notify->be_pid;
+    item.payload = notify->extra;
+    notifications_.push_back(item);
+    PQfreemem(notify);
+
+    if (pCache_) {
+      pCache_->notify(item.channel);
+    }
+    if (pRelations_) {
+      pRelations_->notify(item.channel);
+    }
+  }
+
+  return notifications_.size();
+}
+
+// Created on first use
+PqResultCache& DbConnection::result_cache() {
+  if (!pCache_) {
+    pCache_.reset(new PqResultCache());
+  }
+  return *pCache_;
+}
+
+// Created on first use
+PqRelationCache& DbConnection::relation_cache() {
+  if (!pRelations_) {
+    pRelations_.reset(new PqRelationCache());
+  }
+  return *pRelations_;
+}
+
+// Discards cached catalog information and results after statements that
+// may have changed the schema, the search path or the role
+void DbConnection::command_done(const PGresult* pRes) {
+  if (pRes != NULL) {
+    command_status_ = PQcmdStatus(const_cast<PGresult*>(pRes));
+  }
+  if (pRelations_) {
+    pRelations_->command_done(pRes);
+  }
+  if (pCache_) {
+    pCache_->command_done(pRes);
+  }
+}
+
+const std::string& DbConnection::command_status() const {
+  return command_status_;
+}
+
+void DbConnection::take_notifications(std::vector<PqNotification>& out, size_t n_max) {
+  while (!notifications_.empty() && out.size() < n_max) {
+    out.push_back(notifications_.front());
+    notifications_.pop_front();
+  }
+}
+
+// Waits until any of the connections has received a notification,
+// returns up to n_max notifications as a data frame
+cpp11::list DbConnection::wait_for_notifications(const std::vector<DbConnection*>& conns,
+                                                 int timeout_ms, size_t n_max) {
+  using namespace cpp11::literals;
+
+  size_t pending = 0;
+  for (size_t i = 0; i < conns.size(); ++i) {
+    pending += conns[i]->consume_notifications();
+  }
+
+  if (pending == 0 && timeout_ms != 0) {
+    std::vector<int> sockets;
+    for (size_t i = 0; i < conns.size(); ++i) {
+      sockets.push_back(PQsocket(conns[i]->conn()));
     }
-    FD_ZERO(&input);
-    FD_SET(socket, &input);
-    timeval timeout = {0, 0};
-    timeout.tv_sec = timeout_secs;
-    if (select(socket + 1, &input, NULL, NULL, &timeout) < 0) {
-        cpp11::stop("select() on the connection failed");
+
+    std::vector<bool> ready;
+    if (pq_poll_sockets(sockets, ready, timeout_ms) > 0) {
+      for (size_t i = 0; i < conns.size(); ++i) {
+        if (ready[i])
+          conns[i]->consume_notifications();
+      }
     }
   }
+
+  std::vector<int> connection;
+  std::vector<PqNotification> notifications;
+  for (size_t i = 0; i < conns.size(); ++i) {
+    size_t before = notifications.size();
+    conns[i]->take_notifications(notifications, n_max);
+    connection.insert(connection.end(), notifications.size() - before, static_cast<int>(i) + 1);
+  }
+
+  const R_xlen_t n = notifications.size();
+  cpp11::writable::strings channel(n), payload(n);
+  cpp11::writable::integers pid(n);
+  for (R_xlen_t i = 0; i < n; ++i) {
+    channel[i] = cpp11::r_string(notifications[i].channel);
+    pid[i] = notifications[i].pid;
+    payload[i] = cpp11::r_string(notifications[i].payload);
+  }
+
+  cpp11::writable::list out({
+    "connection"_nm = cpp11::as_sexp(connection),
+    "channel"_nm = channel,
+    "pid"_nm = pid,
+    "payload"_nm = payload
+  });
+  out.attr("row.names") = cpp11::integers({NA_INTEGER, -static_cast<int>(n)});
+  out.attr("class") = "data.frame";
+  return out;
 }
 
 void DbConnection::process_notice(void* /*This*/, const char* message) {
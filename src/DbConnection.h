@@ -3,47 +3,86 @@
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <deque>
+#include <functional>
 
 class DbResult;
+class DbConnectionPool;
+class PqTypeCatalog;
+class PqResultCache;
+class PqRelationCache;
 
 // convenience typedef for shared_ptr to DbConnection
 class DbConnection;
 typedef boost::shared_ptr<DbConnection> DbConnectionPtr;
 
+// PqNotification --------------------------------------------------------------
+
+struct PqNotification {
+  std::string channel;
+  int pid;
+  std::string payload;
+};
+
 // DbConnection ----------------------------------------------------------------
 
 class DbConnection : boost::noncopyable {
   PGconn* pConn_;
-  const DbResult* pCurrentResult_;
+  DbResult* pCurrentResult_;
   bool transacting_;
+  bool broken_;
   bool check_interrupts_;
+  int interrupt_latency_ms_;
   cpp11::strings temp_schema_;
+  DbConnectionPool* pPool_;
+  std::deque<PqNotification> notifications_;
+  boost::shared_ptr<PqTypeCatalog> pCatalog_;
+  boost::scoped_ptr<PqResultCache> pCache_;
+  boost::scoped_ptr<PqRelationCache> pRelations_;
+  std::string command_status_;
 
 public:
   DbConnection(std::vector<std::string> keys, std::vector<std::string> values,
     bool check_interrupts);
+  DbConnection(PGconn* pConn, bool check_interrupts);
   virtual ~DbConnection();
 
+  static void connect_parallel(const std::vector<std::string>& keys,
+                               const std::vector<std::string>& values, int n,
+                               const std::string& init_sql, int timeout_ms,
+                               std::vector<PGconn*>& conns, std::vector<std::string>& errors);
+
 public:
   void disconnect();
 
   PGconn* conn();
 
-  void set_current_result(const DbResult* pResult);
-  void reset_current_result(const DbResult* pResult);
+  void set_current_result(DbResult* pResult);
+  void reset_current_result(DbResult* pResult);
   bool is_current_result(const DbResult* pResult);
   bool has_query();
 
   void copy_data(std::string sql, cpp11::list df);
+  double copy_to_file(const std::string& sql, const std::string& path);
+  void insert_values(const std::string& prefix, const cpp11::list& df, bool redshift,
+                     size_t batch_bytes);
+  static void copy_data_parallel(const std::vector<DbConnection*>& conns, const std::string& sql,
+                                 const cpp11::list& df);
+  void exec(const std::string& sql);
+  void with_transaction(const std::function<void()>& fun);
 
   void check_connection();
   cpp11::list info();
+  cpp11::strings conninfo();
+  cpp11::strings parameter_status(const std::string& name);
+  cpp11::strings typnames(const std::vector<double>& oids);
+  void resolve_types(const std::vector<Oid>& oids);
+  bool has_typname(Oid oid) const;
 
   bool is_check_interrupts() const;
-
-  SEXP quote_string(const cpp11::r_string& x);
-  SEXP quote_identifier(const cpp11::r_string& x);
-  static SEXP get_null_string();
+  int get_interrupt_latency() const;
+  void set_interrupt_latency(int latency_ms);
 
   bool is_transacting() const;
   void set_transacting(bool transacting);
@@ -51,16 +90,36 @@ public:
   cpp11::strings get_temp_schema() const;
   void set_temp_schema(cpp11::strings temp_schema);
 
+  DbConnectionPool* get_pool() const;
+  void set_pool(DbConnectionPool* pPool);
+
   void conn_stop(const char* msg);
   static void conn_stop(PGconn* conn, const char* msg);
 
   void cleanup_query();
   static void finish_query(PGconn* pConn);
+  static bool finish_query(PGconn* pConn, int timeout_ms);
   cpp11::list wait_for_notify(int timeout_secs);
 
+  size_t consume_notifications();
+  void take_notifications(std::vector<PqNotification>& out, size_t n_max);
+  static cpp11::list wait_for_notifications(const std::vector<DbConnection*>& conns, int timeout_ms,
+                                            size_t n_max);
+
   void cancel_query();
 
+  PqResultCache& result_cache();
+  PqRelationCache& relation_cache();
+  void command_done(const PGresult* pRes);
+  const std::string& command_status() const;
+
 private:
+  void init_connection();
+  void suspend_current_result();
+  void wait_for_input();
+  void cancel_copy_out();
+  void abandon_query();
+  static bool poll_reset(PGconn* pConn, int timeout_ms);
   static void process_notice(void* This, const char* message);
 };
 
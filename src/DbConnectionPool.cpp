@@ -0,0 +1,240 @@
+#include "pch.h"
+#include "DbConnectionPool.h"
+#include "DbConnection.h"
+#include "PqPoll.h"
+
+// A connection that doesn't answer the liveness check within this time
+// is considered dead. Connections dropped silently by the network would
+// otherwise block until TCP gives up.
+static const int alive_timeout_ms = 2000;
+
+DbConnectionPool::DbConnectionPool(std::vector<std::string> keys, std::vector<std::string> values,
+                                   bool check_interrupts, int interrupt_latency_ms,
+                                   std::vector<std::string> init_sql, std::string reset_sql,
+                                   int min_size, int max_size, double idle_timeout, double check_interval) :
+  keys_(keys),
+  values_(values),
+  check_interrupts_(check_interrupts),
+  interrupt_latency_ms_(interrupt_latency_ms),
+  init_sql_(init_sql),
+  reset_sql_(reset_sql),
+  min_size_(min_size),
+  max_size_(max_size),
+  idle_timeout_(idle_timeout),
+  check_interval_(check_interval)
+{
+  if (min_size_ < 0 || max_size_ < 1 || min_size_ > max_size_) {
+    cpp11::stop("Invalid pool size: min_size = %d, max_size = %d", min_size_, max_size_);
+  }
+
+  for (int i = 0; i < min_size_; ++i) {
+    IdleConnection idle = { create(), clock::now() };
+    idle_.push_back(idle);
+  }
+}
+
+DbConnectionPool::~DbConnectionPool() {
+  try {
+    close();
+  } catch (...) {}
+}
+
+
+// Publics /////////////////////////////////////////////////////////////////////
+
+DbConnectionPtr DbConnectionPool::acquire() {
+  LOG_DEBUG << idle_.size() << "/" << in_use_.size();
+
+  reclaim();
+  prune();
+
+  // Most recently used connections first, they are least likely to be stale
+  while (!idle_.empty()) {
+    IdleConnection idle = idle_.back();
+    idle_.pop_back();
+
+    if (!is_alive(idle)) {
+      LOG_DEBUG << "Discarding dead connection";
+      discard(idle.pConn);
+      continue;
+    }
+
+    in_use_.push_back(idle.pConn);
+    return idle.pConn;
+  }
+
+  if (size() >= max_size_) {
+    cpp11::stop("Connection pool exhausted, all %d connections are in use", max_size_);
+  }
+
+  DbConnectionPtr pConn = create();
+  in_use_.push_back(pConn);
+  return pConn;
+}
+
+void DbConnectionPool::release(const DbConnectionPtr& pConn) {
+  LOG_DEBUG;
+
+  std::vector<DbConnectionPtr>::iterator it = std::find(in_use_.begin(), in_use_.end(), pConn);
+  if (it == in_use_.end()) {
+    cpp11::stop("Connection does not belong to this pool");
+  }
+  in_use_.erase(it);
+
+  try {
+    reset_session(pConn);
+  } catch (...) {
+    discard(pConn);
+    throw;
+  }
+
+  IdleConnection idle = { pConn, clock::now() };
+  idle_.push_back(idle);
+
+  prune();
+}
+
+void DbConnectionPool::close() {
+  LOG_DEBUG;
+
+  for (size_t i = 0; i < idle_.size(); ++i) {
+    discard(idle_[i].pConn);
+  }
+  idle_.clear();
+
+  // Connections in use stay open until they are disconnected
+  for (size_t i = 0; i < in_use_.size(); ++i) {
+    in_use_[i]->set_pool(NULL);
+  }
+  in_use_.clear();
+}
+
+cpp11::list DbConnectionPool::info() const {
+  using namespace cpp11::literals;
+
+  return cpp11::list({
+    "idle"_nm = static_cast<int>(idle_.size()),
+    "in_use"_nm = static_cast<int>(in_use_.size()),
+    "min_size"_nm = min_size_,
+    "max_size"_nm = max_size_,
+    "idle_timeout"_nm = idle_timeout_
+  });
+}
+
+
+// Privates ///////////////////////////////////////////////////////////////////
+
+DbConnectionPtr DbConnectionPool::create() {
+  LOG_DEBUG;
+
+  DbConnectionPtr pConn(new DbConnection(keys_, values_, check_interrupts_));
+  pConn->set_interrupt_latency(interrupt_latency_ms_);
+  init_session(pConn);
+  pConn->set_pool(this);
+  return pConn;
+}
+
+void DbConnectionPool::init_session(const DbConnectionPtr& pConn) {
+  for (size_t i = 0; i < init_sql_.size(); ++i) {
+    pConn->exec(init_sql_[i]);
+  }
+}
+
+void DbConnectionPool::reset_session(const DbConnectionPtr& pConn) {
+  // Cancels and drains any query still running
+  pConn->set_current_result(NULL);
+  pConn->check_connection();
+
+  if (PQtransactionStatus(pConn->conn()) != PQTRANS_IDLE) {
+    pConn->exec("ROLLBACK");
+  }
+
+  if (!reset_sql_.empty()) {
+    pConn->exec(reset_sql_);
+    init_session(pConn);
+  }
+
+  pConn->set_transacting(false);
+  pConn->set_temp_schema(cpp11::as_sexp(cpp11::r_string(NA_STRING)));
+}
+
+bool DbConnectionPool::is_alive(const IdleConnection& idle) const {
+  PGconn* conn = idle.pConn->conn();
+  if (conn == NULL || PQstatus(conn) != CONNECTION_OK)
+    return false;
+
+  // Does not block, fails if the server has closed the connection
+  if (!PQconsumeInput(conn) || PQtransactionStatus(conn) != PQTRANS_IDLE)
+    return false;
+
+  if (seconds_since(idle.since) < check_interval_)
+    return true;
+
+  // Connections that have been idle for a while might have been dropped
+  // silently by the network, an empty query is the cheapest round trip
+  if (!PQsendQuery(conn, ""))
+    return false;
+
+  clock::time_point deadline = clock::now() + std::chrono::milliseconds(alive_timeout_ms);
+  bool alive = false;
+  for (;;) {
+    if (!PQconsumeInput(conn))
+      return false;
+
+    while (!PQisBusy(conn)) {
+      PGresult* pRes = PQgetResult(conn);
+      if (pRes == NULL)
+        return alive;
+      alive = (PQresultStatus(pRes) == PGRES_EMPTY_QUERY);
+      PQclear(pRes);
+    }
+
+    int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - clock::now()).count());
+    if (remaining <= 0) {
+      LOG_DEBUG << "Connection doesn't respond";
+      return false;
+    }
+
+    std::vector<int> sockets(1, PQsocket(conn));
+    std::vector<bool> ready;
+    pq_poll_sockets(sockets, ready, remaining, false, 0);
+  }
+}
+
+void DbConnectionPool::reclaim() {
+  // The pool holds the only reference to connections whose R object
+  // has been garbage collected
+  for (size_t i = in_use_.size(); i-- > 0; ) {
+    DbConnectionPtr pConn = in_use_[i];
+    if (pConn.use_count() > 2)
+      continue;
+
+    LOG_DEBUG << "Reclaiming connection";
+    try {
+      release(pConn);
+    } catch (...) {}
+  }
+}
+
+void DbConnectionPool::prune() {
+  // Oldest idle connections are at the front
+  while (!idle_.empty() && size() > min_size_ &&
+         seconds_since(idle_.front().since) > idle_timeout_) {
+    discard(idle_.front().pConn);
+    idle_.pop_front();
+  }
+}
+
+void DbConnectionPool::discard(const DbConnectionPtr& pConn) {
+  pConn->set_pool(NULL);
+  pConn->disconnect();
+}
+
+int DbConnectionPool::size() const {
+  return static_cast<int>(idle_.size() + in_use_.size());
+}
+
+double DbConnectionPool::seconds_since(const clock::time_point& since) {
+  return std::chrono::duration<double>(clock::now() - since).count();
+}
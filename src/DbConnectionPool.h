@@ -0,0 +1,73 @@
+#ifndef __RPOSTGRES_PQ_CONNECTION_POOL__
+#define __RPOSTGRES_PQ_CONNECTION_POOL__
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <chrono>
+#include <deque>
+
+class DbConnection;
+typedef boost::shared_ptr<DbConnection> DbConnectionPtr;
+
+class DbConnectionPool;
+typedef boost::shared_ptr<DbConnectionPool> DbConnectionPoolPtr;
+
+// DbConnectionPool ------------------------------------------------------------
+
+// Keeps physical connections open between dbConnect() and dbDisconnect()
+// calls. Connections handed out by acquire() are returned to the pool
+// by connection_release(), their session state is reset on return.
+// The pool keeps references to all connections it has created, connections
+// whose R object has been garbage collected without dbDisconnect()
+// are reclaimed on the next acquire().
+
+class DbConnectionPool : boost::noncopyable {
+  typedef std::chrono::steady_clock clock;
+
+  struct IdleConnection {
+    DbConnectionPtr pConn;
+    clock::time_point since;
+  };
+
+  const std::vector<std::string> keys_;
+  const std::vector<std::string> values_;
+  const bool check_interrupts_;
+  const int interrupt_latency_ms_;
+  const std::vector<std::string> init_sql_;
+  const std::string reset_sql_;
+  const int min_size_;
+  const int max_size_;
+  const double idle_timeout_;
+  const double check_interval_;
+
+  std::deque<IdleConnection> idle_;
+  std::vector<DbConnectionPtr> in_use_;
+
+public:
+  DbConnectionPool(std::vector<std::string> keys, std::vector<std::string> values,
+    bool check_interrupts, int interrupt_latency_ms,
+    std::vector<std::string> init_sql, std::string reset_sql,
+    int min_size, int max_size, double idle_timeout, double check_interval);
+  ~DbConnectionPool();
+
+public:
+  DbConnectionPtr acquire();
+  void release(const DbConnectionPtr& pConn);
+  void close();
+
+  cpp11::list info() const;
+
+private:
+  DbConnectionPtr create();
+  void init_session(const DbConnectionPtr& pConn);
+  void reset_session(const DbConnectionPtr& pConn);
+  bool is_alive(const IdleConnection& idle) const;
+  void reclaim();
+  void prune();
+  void discard(const DbConnectionPtr& pConn);
+  int size() const;
+
+  static double seconds_since(const clock::time_point& since);
+};
+
+#endif
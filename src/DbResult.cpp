@@ -56,6 +56,13 @@ cpp11::list DbResult::fetch(const int n_max) {
   return impl->fetch(n_max);
 }
 
+cpp11::list DbResult::fetch_statements() {
+  if (!is_active())
+    cpp11::stop("Inactive result set");
+
+  return impl->fetch_statements();
+}
+
 cpp11::list DbResult::get_column_info() {
   cpp11::writable::list out = impl->get_column_info();
 
@@ -65,11 +72,33 @@ cpp11::list DbResult::get_column_info() {
   return out;
 }
 
+bool DbResult::is_ready() {
+  if (!is_active())
+    cpp11::stop("Inactive result set");
+
+  return impl->is_ready();
+}
+
+int DbResult::get_socket() const {
+  return impl->get_socket();
+}
+
+void DbResult::set_prefetch(size_t max_bytes) {
+  if (!is_active())
+    cpp11::stop("Inactive result set");
+
+  impl->set_prefetch(max_bytes);
+}
+
 void DbResult::close() {
   // Called from destructor
   if (impl) impl->close();
 }
 
+void DbResult::suspend() {
+  if (impl) impl->suspend();
+}
+
 // Privates ///////////////////////////////////////////////////////////////////
 
 void DbResult::validate_params(const cpp11::list& params) const {
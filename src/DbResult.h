@@ -27,6 +27,7 @@ public:
 
 public:
   void close();
+  void suspend();
 
   bool complete() const;
   bool is_active() const;
@@ -35,9 +36,15 @@ public:
 
   void bind(const cpp11::list& params);
   cpp11::list fetch(int n_max = -1);
+  cpp11::list fetch_statements();
 
   cpp11::list get_column_info();
 
+  bool is_ready();
+  int get_socket() const;
+
+  void set_prefetch(size_t max_bytes);
+
 private:
   void validate_params(const cpp11::list& params) const;
 };
@@ -24,7 +24,7 @@ DATA_TYPE PqColumnDataSource::get_decl_data_type() const {
 
 bool PqColumnDataSource::is_null() const {
   LOG_VERBOSE;
-  return PQgetisnull(get_result(), 0, get_j()) != 0;
+  return PQgetisnull(get_result(), get_row(), get_j()) != 0;
 }
 
 int PqColumnDataSource::fetch_bool() const {
@@ -203,8 +203,12 @@ PGresult* PqColumnDataSource::get_result() const {
   return result_source->get_result();
 }
 
+int PqColumnDataSource::get_row() const {
+  return result_source->get_row();
+}
+
 const char* PqColumnDataSource::get_result_value() const {
-  const char* val = PQgetvalue(get_result(), 0, get_j());
+  const char* val = PQgetvalue(get_result(), get_row(), get_j());
   LOG_VERBOSE << val;
   return val;
 }
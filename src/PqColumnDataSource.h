@@ -34,6 +34,7 @@ public:
 private:
   static double convert_datetime(const char* val);
   PGresult* get_result() const;
+  int get_row() const;
   const char* get_result_value() const;
 };
 
@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "PqLargeObject.h"
+#include "DbConnection.h"
+#include "PqUtils.h"
+
+#include <libpq/libpq-fs.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+PqLargeObject::PqLargeObject(PGconn* pConn, Oid oid, int mode) :
+  pConn_(pConn)
+{
+  fd_ = lo_open(pConn_, oid, mode);
+  if (fd_ < 0)
+    DbConnection::conn_stop(pConn_, "Failed to open large object");
+}
+
+PqLargeObject::~PqLargeObject() {
+  // Errors are reported by the operation that has failed
+  lo_close(pConn_, fd_);
+}
+
+Oid PqLargeObject::create(PGconn* pConn) {
+  Oid oid = lo_creat(pConn, INV_READ | INV_WRITE);
+  if (oid == InvalidOid)
+    DbConnection::conn_stop(pConn, "Failed to create large object");
+  return oid;
+}
+
+void PqLargeObject::unlink(PGconn* pConn, Oid oid) {
+  if (lo_unlink(pConn, oid) < 0)
+    DbConnection::conn_stop(pConn, "Failed to remove large object");
+}
+
+// Publics /////////////////////////////////////////////////////////////////////
+
+int64_t PqLargeObject::size() {
+  pg_int64 size = lo_lseek64(pConn_, fd_, 0, SEEK_END);
+  if (size < 0)
+    DbConnection::conn_stop(pConn_, "Failed to determine size of large object");
+  return size;
+}
+
+void PqLargeObject::seek(int64_t offset) {
+  if (lo_lseek64(pConn_, fd_, offset, SEEK_SET) < 0)
+    DbConnection::conn_stop(pConn_, "Failed to seek in large object");
+}
+
+size_t PqLargeObject::read(char* buf, size_t len) {
+  int n = lo_read(pConn_, fd_, buf, len);
+  if (n < 0)
+    DbConnection::conn_stop(pConn_, "Failed to read large object");
+  return n;
+}
+
+void PqLargeObject::write(const char* buf, size_t len) {
+  // The server may accept less than requested
+  while (len > 0) {
+    int n = lo_write(pConn_, fd_, buf, len);
+    if (n <= 0)
+      DbConnection::conn_stop(pConn_, "Failed to write large object");
+    buf += n;
+    len -= n;
+  }
+}
+
+SEXP PqLargeObject::read_raw(PGconn* pConn, Oid oid, int64_t offset, int64_t length, size_t chunk_size) {
+  PqLargeObject lo(pConn, oid, INV_READ);
+  int64_t n = lo.remaining(offset, length);
+  if (n > R_XLEN_T_MAX)
+    cpp11::stop("Large object is too large for a raw vector, read it into a file.");
+
+  cpp11::sexp out = Rf_allocVector(RAWSXP, static_cast<R_xlen_t>(n));
+  char* data = reinterpret_cast<char*>(RAW(out));
+
+  int64_t pos = 0;
+  while (pos < n) {
+    size_t len = static_cast<size_t>(std::min<int64_t>(chunk_size, n - pos));
+    size_t got = lo.read(data + pos, len);
+    if (got == 0)
+      break;
+    pos += got;
+    cpp11::check_user_interrupt();
+  }
+
+  // The object has been truncated by another transaction in the meantime
+  if (pos < n) {
+    out = Rf_xlengthgets(out, static_cast<R_xlen_t>(pos));
+  }
+
+  return out;
+}
+
+int64_t PqLargeObject::read_file(PGconn* pConn, Oid oid, int64_t offset, int64_t length,
+                                 size_t chunk_size, const std::string& path) {
+  PqLargeObject lo(pConn, oid, INV_READ);
+  int64_t n = lo.remaining(offset, length);
+
+  FILE* file = open_file(path, "wb");
+  FileCloser closer(file);
+
+  std::vector<char> buffer(chunk_size);
+  int64_t pos = 0;
+  while (pos < n) {
+    size_t len = static_cast<size_t>(std::min<int64_t>(chunk_size, n - pos));
+    size_t got = lo.read(&buffer[0], len);
+    if (got == 0)
+      break;
+    if (fwrite(&buffer[0], 1, got, file) != got)
+      cpp11::stop("Failed to write to file '%s': %s", path.c_str(), strerror(errno));
+    pos += got;
+    cpp11::check_user_interrupt();
+  }
+
+  if (closer.close() != 0)
+    cpp11::stop("Failed to write to file '%s': %s", path.c_str(), strerror(errno));
+
+  return pos;
+}
+
+Oid PqLargeObject::write_raw(PGconn* pConn, SEXP data, size_t chunk_size) {
+  Oid oid = create(pConn);
+  PqLargeObject lo(pConn, oid, INV_WRITE);
+
+  const char* p = reinterpret_cast<const char*>(RAW(data));
+  R_xlen_t n = Rf_xlength(data);
+
+  for (R_xlen_t pos = 0; pos < n; ) {
+    size_t len = static_cast<size_t>(std::min<R_xlen_t>(chunk_size, n - pos));
+    lo.write(p + pos, len);
+    pos += len;
+    cpp11::check_user_interrupt();
+  }
+
+  return oid;
+}
+
+Oid PqLargeObject::write_file(PGconn* pConn, const std::string& path, size_t chunk_size) {
+  FILE* file = open_file(path, "rb");
+  FileCloser closer(file);
+
+  Oid oid = create(pConn);
+  PqLargeObject lo(pConn, oid, INV_WRITE);
+
+  std::vector<char> buffer(chunk_size);
+  for (;;) {
+    size_t got = fread(&buffer[0], 1, chunk_size, file);
+    if (got > 0)
+      lo.write(&buffer[0], got);
+    if (got < chunk_size) {
+      if (ferror(file))
+        cpp11::stop("Failed to read from file '%s': %s", path.c_str(), strerror(errno));
+      break;
+    }
+    cpp11::check_user_interrupt();
+  }
+
+  return oid;
+}
+
+// Privates ////////////////////////////////////////////////////////////////////
+
+// Positions the descriptor at `offset`, returns the number of bytes to read
+int64_t PqLargeObject::remaining(int64_t offset, int64_t length) {
+  int64_t total = size();
+  int64_t n = std::max<int64_t>(total - offset, 0);
+  if (length >= 0 && length < n)
+    n = length;
+
+  seek(offset);
+  return n;
+}
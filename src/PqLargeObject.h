@@ -0,0 +1,47 @@
+#ifndef __RPOSTGRES_PQ_LARGE_OBJECT__
+#define __RPOSTGRES_PQ_LARGE_OBJECT__
+
+#include <boost/noncopyable.hpp>
+#include <cstdio>
+
+// PqLargeObject ---------------------------------------------------------------
+
+// An open descriptor of a large object, closed by the destructor.
+// Large object descriptors are only valid in the transaction that opened
+// them, the caller is responsible for the transaction.
+//
+// The static functions transfer the contents of large objects to and from
+// raw vectors and local files in chunks of a fixed size, so that files of
+// any size can be transferred with constant memory.
+
+class PqLargeObject : boost::noncopyable {
+  PGconn* pConn_;
+  int fd_;
+
+public:
+  PqLargeObject(PGconn* pConn, Oid oid, int mode);
+  ~PqLargeObject();
+
+  static Oid create(PGconn* pConn);
+  static void unlink(PGconn* pConn, Oid oid);
+
+public:
+  int64_t size();
+  void seek(int64_t offset);
+  size_t read(char* buf, size_t len);
+  void write(const char* buf, size_t len);
+
+  // Reads at most `length` bytes (all if negative) from `offset`
+  static SEXP read_raw(PGconn* pConn, Oid oid, int64_t offset, int64_t length, size_t chunk_size);
+  static int64_t read_file(PGconn* pConn, Oid oid, int64_t offset, int64_t length, size_t chunk_size,
+                           const std::string& path);
+
+  // Writes to a new large object, returns its OID
+  static Oid write_raw(PGconn* pConn, SEXP data, size_t chunk_size);
+  static Oid write_file(PGconn* pConn, const std::string& path, size_t chunk_size);
+
+private:
+  int64_t remaining(int64_t offset, int64_t length);
+};
+
+#endif // __RPOSTGRES_PQ_LARGE_OBJECT__
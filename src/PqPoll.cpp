@@ -0,0 +1,101 @@
+#include "pch.h"
+#include "PqPoll.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#define SOCKERR WSAGetLastError()
+#define SOCKET_EINTR WSAEINTR
+#define pq_poll_impl WSAPoll
+typedef WSAPOLLFD pq_pollfd;
+#else
+#include <errno.h>
+#include <poll.h>
+#define SOCKERR errno
+#define SOCKET_EINTR EINTR
+#define pq_poll_impl poll
+typedef struct pollfd pq_pollfd;
+#endif
+
+#include <algorithm>
+
+int pq_poll_sockets(const std::vector<int>& sockets, std::vector<bool>& ready, int timeout_ms,
+                    bool write, int interrupt_ms) {
+  return pq_poll_sockets(sockets, std::vector<bool>(sockets.size(), write), ready, timeout_ms,
+                         interrupt_ms);
+}
+
+int pq_poll_sockets(const std::vector<int>& sockets, const std::vector<bool>& write,
+                    std::vector<bool>& ready, int timeout_ms, int interrupt_ms) {
+  LOG_DEBUG << sockets.size() << ", " << timeout_ms;
+
+  ready.assign(sockets.size(), false);
+  if (sockets.empty()) {
+    return 0;
+  }
+
+  std::vector<pq_pollfd> fds(sockets.size());
+  for (size_t i = 0; i < sockets.size(); ++i) {
+    if (sockets[i] < 0) {
+      cpp11::stop("Failed to get connection socket");
+    }
+    fds[i].fd = sockets[i];
+    fds[i].events = write[i] ? (POLLIN | POLLOUT) : POLLIN;
+    fds[i].revents = 0;
+  }
+
+  int remaining = timeout_ms;
+
+  for (;;) {
+    // check for user interrupts in between, unless disabled
+    int slice = remaining;
+    if (interrupt_ms > 0) {
+      slice = (remaining < 0) ? interrupt_ms : std::min(remaining, interrupt_ms);
+    }
+
+    int ret = pq_poll_impl(&fds[0], fds.size(), slice);
+    if (ret > 0) {
+      int n = 0;
+      for (size_t i = 0; i < fds.size(); ++i) {
+        // errors and hangups are reported as readable,
+        // PQconsumeInput() will report them
+        if (fds[i].revents != 0) {
+          ready[i] = true;
+          ++n;
+        }
+      }
+      return n;
+    }
+
+    if (ret < 0 && SOCKERR != SOCKET_EINTR) {
+      cpp11::stop("poll() failed with error code %d", SOCKERR);
+    }
+
+    if (interrupt_ms > 0) {
+      cpp11::check_user_interrupt();
+    }
+
+    if (ret == 0 && remaining >= 0) {
+      remaining -= slice;
+      if (remaining <= 0) {
+        return 0;
+      }
+    }
+  }
+}
+
+int pq_wait_socket(int socket, int timeout_ms) {
+  if (socket < 0) {
+    return -1;
+  }
+
+  pq_pollfd fd;
+  fd.fd = socket;
+  fd.events = POLLIN;
+  fd.revents = 0;
+
+  int ret = pq_poll_impl(&fd, 1, timeout_ms);
+  if (ret < 0) {
+    return (SOCKERR == SOCKET_EINTR) ? 0 : -1;
+  }
+  return (ret > 0) ? 1 : 0;
+}
@@ -0,0 +1,23 @@
+#ifndef __RPOSTGRES_PQ_POLL__
+#define __RPOSTGRES_PQ_POLL__
+
+// Waits until at least one of the sockets is readable (or writable, if
+// `write` is set), or until the timeout (in milliseconds, negative for no
+// timeout) expires. User interrupts are checked every `interrupt_ms`
+// milliseconds while waiting, a non-positive value disables the checks.
+//
+// Sets `ready[i]` for each ready socket, returns the number of
+// ready sockets.
+int pq_poll_sockets(const std::vector<int>& sockets, std::vector<bool>& ready, int timeout_ms,
+                    bool write = false, int interrupt_ms = 1000);
+
+// Same as above, with `write` set for each socket individually.
+int pq_poll_sockets(const std::vector<int>& sockets, const std::vector<bool>& write,
+                    std::vector<bool>& ready, int timeout_ms, int interrupt_ms = 1000);
+
+// Waits until the socket is readable, or until the timeout expires.
+// Doesn't use the R API, can be called from any thread.
+// Returns 1 if the socket is ready, 0 on timeout, -1 on error.
+int pq_wait_socket(int socket, int timeout_ms);
+
+#endif // __RPOSTGRES_PQ_POLL__
@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "PqPrefetch.h"
+#include "PqPoll.h"
+
+#include <chrono>
+
+// How often the thread checks if it should stop while waiting for data
+static const int prefetch_poll_ms = 20;
+
+// Number of rows that can be buffered, independently of their size
+static const size_t prefetch_max_rows = 8192;
+
+PqPrefetcher::PqPrefetcher(PGconn* pConn, void* notice_arg) :
+  pConn_(pConn),
+  max_bytes_(0),
+  stop_(false),
+  done_(false),
+  running_(false),
+  queue_(prefetch_max_rows),
+  bytes_(0),
+  notice_processor_(NULL),
+  notice_arg_(notice_arg)
+{
+}
+
+PqPrefetcher::~PqPrefetcher() {
+  try {
+    stop();
+  } catch (...) {}
+  clear();
+}
+
+// Publics /////////////////////////////////////////////////////////////////////
+
+void PqPrefetcher::set_max_bytes(size_t max_bytes) {
+  max_bytes_ = max_bytes;
+}
+
+void PqPrefetcher::start() {
+  if (running_ || max_bytes_ == 0)
+    return;
+
+  LOG_DEBUG << bytes_ << "/" << max_bytes_;
+
+  notice_processor_ = PQsetNoticeProcessor(pConn_, &PqPrefetcher::collect_notice, this);
+  stop_ = false;
+  done_ = false;
+  running_ = true;
+
+  try {
+    thread_ = std::thread(&PqPrefetcher::run, this);
+  } catch (...) {
+    // Prefetching is an optimization, the rows are read by the caller instead
+    running_ = false;
+    PQsetNoticeProcessor(pConn_, notice_processor_, notice_arg_);
+  }
+}
+
+void PqPrefetcher::stop() {
+  if (!running_)
+    return;
+
+  stop_ = true;
+  thread_.join();
+  running_ = false;
+
+  LOG_DEBUG << bytes_;
+
+  PQsetNoticeProcessor(pConn_, notice_processor_, notice_arg_);
+
+  std::vector<std::string> notices;
+  notices.swap(notices_);
+  for (size_t i = 0; i < notices.size(); ++i) {
+    notice_processor_(notice_arg_, notices[i].c_str());
+  }
+}
+
+bool PqPrefetcher::is_running() const {
+  return running_;
+}
+
+bool PqPrefetcher::is_done() const {
+  return done_;
+}
+
+bool PqPrefetcher::pop(PGresult*& res) {
+  if (!queue_.pop(res))
+    return false;
+
+  bytes_ -= result_size(res);
+  return true;
+}
+
+bool PqPrefetcher::wait(int timeout_ms) {
+  typedef std::chrono::steady_clock clock;
+  const clock::time_point deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+
+  // Rows usually arrive much faster than the timeout, the first few
+  // checks only yield to the I/O thread
+  for (int i = 0; ; ++i) {
+    if (!queue_.empty() || done_)
+      return true;
+    if (clock::now() >= deadline)
+      return false;
+
+    if (i < 100)
+      std::this_thread::yield();
+    else
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+void PqPrefetcher::clear() {
+  PGresult* res;
+  while (pop(res)) {
+    PQclear(res);
+  }
+}
+
+// Privates ////////////////////////////////////////////////////////////////////
+
+// Runs on the I/O thread. Ends at the first result that isn't a single row:
+// the end of the query or an error is handled by the main thread,
+// which may also need to send the next query.
+void PqPrefetcher::run() {
+  try {
+    const int socket = PQsocket(pConn_);
+
+    while (!stop_) {
+      // Wait for the main thread to catch up
+      if (bytes_ >= max_bytes_ || queue_.full()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+
+      if (!PQconsumeInput(pConn_))
+        break;
+
+      if (PQisBusy(pConn_)) {
+        if (pq_wait_socket(socket, prefetch_poll_ms) < 0)
+          break;
+        continue;
+      }
+
+      PGresult* res = PQgetResult(pConn_);
+      if (res == NULL)
+        break;
+
+      // Only this thread adds to the queue, there is room
+      bytes_ += result_size(res);
+      queue_.push(res);
+
+      if (PQresultStatus(res) != PGRES_SINGLE_TUPLE)
+        break;
+    }
+  } catch (...) {
+    // The main thread reads the remaining rows and reports errors
+  }
+
+  done_ = true;
+}
+
+size_t PqPrefetcher::result_size(const PGresult* res) {
+  size_t size = sizeof(PGresult*);
+  int ncols = PQnfields(res);
+  for (int j = 0; j < ncols; ++j) {
+    size += PQgetlength(res, 0, j) + 1;
+  }
+  return size;
+}
+
+void PqPrefetcher::collect_notice(void* This, const char* message) {
+  static_cast<PqPrefetcher*>(This)->notices_.push_back(message);
+}
@@ -0,0 +1,69 @@
+#ifndef __RPOSTGRES_PQ_PREFETCH__
+#define __RPOSTGRES_PQ_PREFETCH__
+
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <thread>
+#include "PqSpscQueue.h"
+
+// PqPrefetcher ----------------------------------------------------------------
+
+// Reads the rows of a query in single-row mode on a dedicated I/O thread.
+// The rows are handed to the main thread through a lock-free queue, so that
+// receiving rows overlaps with converting them to R vectors, and with
+// whatever R does between calls to dbFetch(). The thread pauses while the
+// buffered rows take up more than a limit, and ends after the last row of
+// the query.
+//
+// While the thread runs, the connection must not be used otherwise:
+// start() and stop() are called on the main thread, pop() and wait() may be
+// called while the thread runs. The thread doesn't use the R API: notices
+// received in the background are collected, and passed on to the notice
+// processor of the connection by stop().
+
+class PqPrefetcher : boost::noncopyable {
+  PGconn* pConn_;
+  size_t max_bytes_;
+
+  std::thread thread_;
+  std::atomic<bool> stop_;
+  std::atomic<bool> done_;
+  bool running_;
+
+  PqSpscQueue<PGresult*> queue_;
+  std::atomic<size_t> bytes_;
+
+  std::vector<std::string> notices_;
+  PQnoticeProcessor notice_processor_;
+  void* notice_arg_;
+
+public:
+  // `notice_arg` is the argument of the notice processor of the connection
+  PqPrefetcher(PGconn* pConn, void* notice_arg);
+  ~PqPrefetcher();
+
+public:
+  void set_max_bytes(size_t max_bytes);
+
+  void start();
+  void stop();
+
+  // True until stop() has been called, even if the thread has ended
+  bool is_running() const;
+  // True if the thread has ended, the remaining rows can be popped
+  bool is_done() const;
+
+  // Takes the oldest buffered result, returns false if there is none
+  bool pop(PGresult*& res);
+  // Waits until a result can be popped or the thread has ended,
+  // returns false on timeout
+  bool wait(int timeout_ms);
+  void clear();
+
+private:
+  void run();
+  static size_t result_size(const PGresult* res);
+  static void collect_notice(void* This, const char* message);
+};
+
+#endif // __RPOSTGRES_PQ_PREFETCH__
@@ -0,0 +1,346 @@
+#include "pch.h"
+#include "PqQuote.h"
+#include "PqUtils.h"
+#include "integer64.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+PqQuoter::PqQuoter(PGconn* pConn, bool redshift) :
+  pConn_(pConn),
+  redshift_(redshift)
+{
+  utf8_ = (strcmp(pg_encoding_to_char(PQclientEncoding(pConn_)), "UTF8") == 0);
+
+  const char* scs = PQparameterStatus(pConn_, "standard_conforming_strings");
+  standard_strings_ = (scs != NULL && strcmp(scs, "on") == 0);
+}
+
+// Publics /////////////////////////////////////////////////////////////////////
+
+cpp11::strings PqQuoter::quote_strings(const cpp11::strings& xs) {
+  R_xlen_t n = xs.size();
+  cpp11::writable::strings out(n);
+
+  for (R_xlen_t i = 0; i < n; ++i) {
+    SEXP x = STRING_ELT(xs, i);
+    buffer_.clear();
+    if (x == NA_STRING) {
+      append_null(redshift_ ? "varchar(max)" : NULL);
+    } else {
+      append_string(Rf_translateCharUTF8(x));
+    }
+    SET_STRING_ELT(out, i, make_char());
+  }
+
+  return out;
+}
+
+// Identifiers in other encodings are converted to UTF-8, like the output
+cpp11::strings PqQuoter::quote_identifiers(const cpp11::strings& xs) {
+  R_xlen_t n = xs.size();
+  cpp11::writable::strings out(n);
+
+  for (R_xlen_t i = 0; i < n; ++i) {
+    buffer_.clear();
+    append_identifier(Rf_translateCharUTF8(STRING_ELT(xs, i)));
+    SET_STRING_ELT(out, i, make_char());
+  }
+
+  return out;
+}
+
+// Dates and times are expected as numbers with class "Date" and "POSIXct".
+// Times are formatted as timestamp without time zone, the caller
+// converts them to the wall clock time of the connection.
+cpp11::strings PqQuoter::quote_literals(SEXP x) {
+  PqLiteralKind kind = literal_kind(x);
+
+  R_xlen_t n = Rf_xlength(x);
+  cpp11::writable::strings out(n);
+
+  for (R_xlen_t i = 0; i < n; ++i) {
+    buffer_.clear();
+    append_literal(x, kind, i);
+    SET_STRING_ELT(out, i, make_char());
+  }
+
+  return out;
+}
+
+PqLiteralKind PqQuoter::literal_kind(SEXP x) {
+  switch (TYPEOF(x)) {
+  case STRSXP:
+    return LIT_STRING;
+  case LGLSXP:
+    return LIT_LOGICAL;
+  case INTSXP:
+    return Rf_inherits(x, "Date") ? LIT_DATE_INT : LIT_INTEGER;
+  case REALSXP:
+    if (Rf_inherits(x, "integer64"))
+      return LIT_INTEGER64;
+    if (Rf_inherits(x, "Date"))
+      return LIT_DATE;
+    if (Rf_inherits(x, "POSIXct"))
+      return LIT_TIMESTAMP;
+    return LIT_DOUBLE;
+  case VECSXP:
+    return LIT_BLOB;
+  default:
+    cpp11::stop("Can't convert value of type %s to SQL.", Rf_type2char(TYPEOF(x)));
+  }
+}
+
+void PqQuoter::clear() {
+  buffer_.clear();
+}
+
+void PqQuoter::append_sql(const std::string& sql) {
+  buffer_ += sql;
+}
+
+// Appends the i-th element of x as a literal, kind is from literal_kind(x)
+void PqQuoter::append_literal(SEXP x, PqLiteralKind kind, R_xlen_t i) {
+  char buf[32];
+
+  switch (kind) {
+  case LIT_STRING: {
+    SEXP value = STRING_ELT(x, i);
+    if (value == NA_STRING)
+      append_null(redshift_ ? "varchar(max)" : NULL);
+    else
+      append_string(Rf_translateCharUTF8(value));
+    break;
+  }
+
+  case LIT_LOGICAL: {
+    int value = LOGICAL(x)[i];
+    if (value == NA_LOGICAL)
+      append_null("bool");
+    else
+      buffer_ += value ? "TRUE" : "FALSE";
+    break;
+  }
+
+  case LIT_INTEGER: {
+    int value = INTEGER(x)[i];
+    if (value == NA_INTEGER) {
+      append_null("int4");
+    } else {
+      snprintf(buf, sizeof(buf), "%d::int4", value);
+      buffer_ += buf;
+    }
+    break;
+  }
+
+  case LIT_INTEGER64: {
+    int64_t value = INTEGER64(x)[i];
+    if (value == static_cast<int64_t>(NA_INTEGER64)) {
+      append_null("int8");
+    } else {
+      snprintf(buf, sizeof(buf), "%lld::int8", static_cast<long long>(value));
+      buffer_ += buf;
+    }
+    break;
+  }
+
+  case LIT_DATE_INT: {
+    int value = INTEGER(x)[i];
+    append_date(value == NA_INTEGER ? NA_REAL : value);
+    break;
+  }
+
+  case LIT_DATE:
+    append_date(REAL(x)[i]);
+    break;
+
+  case LIT_TIMESTAMP:
+    append_timestamp(REAL(x)[i]);
+    break;
+
+  case LIT_DOUBLE:
+    append_double(REAL(x)[i]);
+    break;
+
+  case LIT_BLOB:
+    append_blob(VECTOR_ELT(x, i));
+    break;
+  }
+}
+
+const std::string& PqQuoter::sql() const {
+  return buffer_;
+}
+
+// Privates ////////////////////////////////////////////////////////////////////
+
+void PqQuoter::append_string(const char* x) {
+  if (!utf8_ && !redshift_) {
+    char* escaped = PQescapeLiteral(pConn_, x, strlen(x));
+    if (escaped == NULL)
+      cpp11::stop(PQerrorMessage(pConn_));
+    buffer_ += escaped;
+    PQfreemem(escaped);
+    return;
+  }
+
+  // Redshift treats backslashes as escape characters, but doesn't support
+  // the E'' syntax. Without standard_conforming_strings, Postgres needs E''
+  // for strings with backslashes, in the same way as PQescapeLiteral().
+  bool escape_backslash = redshift_ || !standard_strings_;
+  if (escape_backslash && !redshift_ && strchr(x, '\\') != NULL) {
+    buffer_ += " E";
+  }
+
+  buffer_ += '\'';
+  for (const char* p = x; *p; ++p) {
+    if (*p == '\'' || (*p == '\\' && escape_backslash)) {
+      buffer_ += *p;
+    }
+    buffer_ += *p;
+  }
+  buffer_ += '\'';
+}
+
+void PqQuoter::append_identifier(const char* x) {
+  if (!utf8_) {
+    char* escaped = PQescapeIdentifier(pConn_, x, strlen(x));
+    if (escaped == NULL)
+      cpp11::stop(PQerrorMessage(pConn_));
+    buffer_ += escaped;
+    PQfreemem(escaped);
+    return;
+  }
+
+  buffer_ += '"';
+  for (const char* p = x; *p; ++p) {
+    if (*p == '"') {
+      buffer_ += '"';
+    }
+    buffer_ += *p;
+  }
+  buffer_ += '"';
+}
+
+void PqQuoter::append_date(double days) {
+  if (ISNAN(days)) {
+    append_null("date");
+    return;
+  }
+  if (std::isinf(days)) {
+    buffer_ += (days > 0) ? "'infinity'::date" : "'-infinity'::date";
+    return;
+  }
+
+  int y, m, d;
+  civil_from_days(static_cast<int>(std::floor(days)), y, m, d);
+
+  char buf[32];
+  if (y > 0) {
+    snprintf(buf, sizeof(buf), "'%04d-%02d-%02d'::date", y, m, d);
+  } else {
+    // There is no year zero, 0 is 1 BC
+    snprintf(buf, sizeof(buf), "'%04d-%02d-%02d BC'::date", 1 - y, m, d);
+  }
+  buffer_ += buf;
+}
+
+void PqQuoter::append_timestamp(double secs) {
+  if (ISNAN(secs)) {
+    append_null("timestamp");
+    return;
+  }
+  if (std::isinf(secs)) {
+    buffer_ += (secs > 0) ? "'infinity'::timestamp" : "'-infinity'::timestamp";
+    return;
+  }
+
+  const int64_t micros_per_day = 86400000000LL;
+
+  double days = std::floor(secs / 86400);
+  int64_t micros = std::llround((secs - days * 86400) * 1e6);
+  if (micros >= micros_per_day) {
+    days += 1;
+    micros -= micros_per_day;
+  }
+
+  int y, m, d;
+  civil_from_days(static_cast<int>(days), y, m, d);
+
+  int time = static_cast<int>(micros / 1000000);
+  int frac = static_cast<int>(micros % 1000000);
+
+  char buf[64];
+  snprintf(buf, sizeof(buf), "'%04d-%02d-%02d %02d:%02d:%02d",
+           y > 0 ? y : 1 - y, m, d, time / 3600, (time / 60) % 60, time % 60);
+  buffer_ += buf;
+
+  if (frac != 0) {
+    snprintf(buf, sizeof(buf), ".%06d", frac);
+    size_t len = strlen(buf);
+    while (buf[len - 1] == '0') --len;
+    buffer_.append(buf, len);
+  }
+
+  if (y <= 0) {
+    buffer_ += " BC";
+  }
+  buffer_ += "'::timestamp";
+}
+
+void PqQuoter::append_double(double x) {
+  if (ISNAN(x)) {
+    append_null("float8");
+    return;
+  }
+  if (std::isinf(x)) {
+    buffer_ += (x > 0) ? "'Infinity'::float8" : "'-Infinity'::float8";
+    return;
+  }
+
+  // Shortest representation that reads back as the same number
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.15g", x);
+  if (strtod(buf, NULL) != x) {
+    snprintf(buf, sizeof(buf), "%.17g", x);
+  }
+  buffer_ += buf;
+  buffer_ += "::float8";
+}
+
+void PqQuoter::append_blob(SEXP x) {
+  if (Rf_isNull(x)) {
+    append_null("bytea");
+    return;
+  }
+  if (TYPEOF(x) != RAWSXP) {
+    cpp11::stop("Lists must contain raw vectors or NULL");
+  }
+
+  static const char hex[] = "0123456789abcdef";
+
+  R_xlen_t n = Rf_xlength(x);
+  const Rbyte* data = RAW(x);
+
+  buffer_.reserve(buffer_.size() + 2 * n + 8);
+  buffer_ += "E'\\\\x";
+  for (R_xlen_t i = 0; i < n; ++i) {
+    buffer_ += hex[data[i] >> 4];
+    buffer_ += hex[data[i] & 0x0f];
+  }
+  buffer_ += '\'';
+}
+
+void PqQuoter::append_null(const char* type) {
+  buffer_ += "NULL";
+  if (type != NULL) {
+    buffer_ += "::";
+    buffer_ += type;
+  }
+}
+
+SEXP PqQuoter::make_char() const {
+  return Rf_mkCharLenCE(buffer_.data(), static_cast<int>(buffer_.size()), CE_UTF8);
+}
@@ -0,0 +1,61 @@
+#ifndef __RPOSTGRES_PQ_QUOTE__
+#define __RPOSTGRES_PQ_QUOTE__
+
+#include <boost/noncopyable.hpp>
+
+enum PqLiteralKind {
+  LIT_STRING,
+  LIT_LOGICAL,
+  LIT_INTEGER,
+  LIT_INTEGER64,
+  LIT_DOUBLE,
+  LIT_DATE,
+  LIT_DATE_INT,
+  LIT_TIMESTAMP,
+  LIT_BLOB
+};
+
+// PqQuoter --------------------------------------------------------------------
+
+// Quotes whole vectors of strings, identifiers and literals for one
+// connection. The connection settings that affect quoting are read once
+// on construction, all elements are escaped into the same buffer.
+//
+// Escaping is done byte by byte, which is safe for UTF-8 because quotes
+// and backslashes never occur inside multibyte characters. Connections with
+// another client encoding use libpq's escaping functions.
+
+class PqQuoter : boost::noncopyable {
+  PGconn* pConn_;
+  bool redshift_;
+  bool utf8_;
+  bool standard_strings_;
+  std::string buffer_;
+
+public:
+  PqQuoter(PGconn* pConn, bool redshift);
+
+public:
+  cpp11::strings quote_strings(const cpp11::strings& xs);
+  cpp11::strings quote_identifiers(const cpp11::strings& xs);
+  cpp11::strings quote_literals(SEXP x);
+
+  // For building a statement in the buffer
+  static PqLiteralKind literal_kind(SEXP x);
+  void clear();
+  void append_sql(const std::string& sql);
+  void append_literal(SEXP x, PqLiteralKind kind, R_xlen_t i);
+  const std::string& sql() const;
+
+private:
+  void append_string(const char* x);
+  void append_identifier(const char* x);
+  void append_date(double days);
+  void append_timestamp(double secs);
+  void append_double(double x);
+  void append_blob(SEXP x);
+  void append_null(const char* type);
+  SEXP make_char() const;
+};
+
+#endif // __RPOSTGRES_PQ_QUOTE__
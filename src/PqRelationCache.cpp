@@ -0,0 +1,94 @@
+#include "pch.h"
+#include "PqRelationCache.h"
+
+#include <cstring>
+
+PqRelationCache::PqRelationCache() :
+  enabled_(false)
+{
+}
+
+// Publics /////////////////////////////////////////////////////////////////////
+
+void PqRelationCache::configure(bool enabled, const std::vector<std::string>& channels) {
+  enabled_ = enabled;
+  channels_ = std::set<std::string>(channels.begin(), channels.end());
+
+  if (!enabled_)
+    clear();
+}
+
+bool PqRelationCache::enabled() const {
+  return enabled_;
+}
+
+SEXP PqRelationCache::get() const {
+  return value_;
+}
+
+void PqRelationCache::put(SEXP value) {
+  if (!enabled_)
+    return;
+
+  value_ = value;
+}
+
+void PqRelationCache::notify(const std::string& channel) {
+  if (channels_.count(channel) == 0)
+    return;
+
+  LOG_DEBUG << channel;
+  clear();
+}
+
+// Called with the final result of each statement run on the connection
+void PqRelationCache::command_done(const PGresult* pRes) {
+  if (Rf_isNull(value_) || !changes_schema(pRes))
+    return;
+
+  LOG_DEBUG << PQcmdStatus(const_cast<PGresult*>(pRes));
+  clear();
+}
+
+void PqRelationCache::clear() {
+  value_ = R_NilValue;
+}
+
+cpp11::list PqRelationCache::info() const {
+  using namespace cpp11::literals;
+
+  cpp11::writable::strings channels;
+  for (std::set<std::string>::const_iterator it = channels_.begin(); it != channels_.end(); ++it) {
+    channels.push_back(cpp11::r_string(*it));
+  }
+
+  return cpp11::writable::list({
+    "enabled"_nm = enabled_,
+    "channels"_nm = channels,
+    "loaded"_nm = !Rf_isNull(value_)
+  });
+}
+
+// Privates ////////////////////////////////////////////////////////////////////
+
+// Decides by the command tag. ROLLBACK may undo DDL, SET and RESET may change
+// the search path, DO and CALL may run anything. CREATE TABLE AS and
+// SELECT INTO are reported as SELECT, but return no rows.
+bool PqRelationCache::changes_schema(const PGresult* pRes) {
+  static const char* const prefixes[] = {
+    "CREATE", "DROP", "ALTER", "IMPORT", "ROLLBACK", "SET", "RESET", "DISCARD", "DO", "CALL"
+  };
+
+  if (pRes == NULL)
+    return false;
+
+  const char* tag = PQcmdStatus(const_cast<PGresult*>(pRes));
+
+  for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); ++i) {
+    size_t len = strlen(prefixes[i]);
+    if (strncmp(tag, prefixes[i], len) == 0 && (tag[len] == '\0' || tag[len] == ' '))
+      return true;
+  }
+
+  return strncmp(tag, "SELECT ", 7) == 0 && PQresultStatus(pRes) == PGRES_COMMAND_OK;
+}
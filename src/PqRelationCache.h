@@ -0,0 +1,40 @@
+#ifndef __RPOSTGRES_PQ_RELATION_CACHE__
+#define __RPOSTGRES_PQ_RELATION_CACHE__
+
+#include <boost/noncopyable.hpp>
+#include <set>
+
+// PqRelationCache -------------------------------------------------------------
+
+// The relations, columns and schema search path of a connection, as loaded
+// from pg_catalog by the R code in a single query. The cached value is
+// discarded when the connection runs a statement that may change the schema
+// or the search path, and when a notification arrives on one of the
+// configured channels (e.g. sent by an event trigger).
+
+class PqRelationCache : boost::noncopyable {
+  bool enabled_;
+  cpp11::sexp value_;
+  std::set<std::string> channels_;
+
+public:
+  PqRelationCache();
+
+public:
+  void configure(bool enabled, const std::vector<std::string>& channels);
+  bool enabled() const;
+
+  // Returns NULL if nothing has been loaded since the last invalidation
+  SEXP get() const;
+  void put(SEXP value);
+
+  void notify(const std::string& channel);
+  void command_done(const PGresult* pRes);
+  void clear();
+  cpp11::list info() const;
+
+private:
+  static bool changes_schema(const PGresult* pRes);
+};
+
+#endif // __RPOSTGRES_PQ_RELATION_CACHE__
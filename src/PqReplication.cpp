@@ -0,0 +1,531 @@
+#include "pch.h"
+#include "PqReplication.h"
+#include "PqPoll.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Seconds from the Unix epoch to the Postgres epoch (2000-01-01)
+const int64_t postgres_epoch_secs = 946684800;
+
+// Big-endian integers in the replication protocol
+
+class MessageReader {
+  const char*& p_;
+  const char* end_;
+
+public:
+  MessageReader(const char*& p, const char* end) : p_(p), end_(end) {}
+
+  void need(size_t n) {
+    if (static_cast<size_t>(end_ - p_) < n)
+      cpp11::stop("Malformed replication message");
+  }
+
+  uint8_t u8() {
+    need(1);
+    return static_cast<uint8_t>(*p_++);
+  }
+
+  uint64_t uint(size_t n) {
+    need(n);
+    uint64_t x = 0;
+    for (size_t i = 0; i < n; ++i) {
+      x = (x << 8) | static_cast<uint8_t>(*p_++);
+    }
+    return x;
+  }
+
+  uint16_t u16() { return static_cast<uint16_t>(uint(2)); }
+  uint32_t u32() { return static_cast<uint32_t>(uint(4)); }
+  uint64_t u64() { return uint(8); }
+
+  std::string str() {
+    const char* nul = static_cast<const char*>(memchr(p_, '\0', end_ - p_));
+    if (nul == NULL)
+      cpp11::stop("Malformed replication message");
+    std::string s(p_, nul);
+    p_ = nul + 1;
+    return s;
+  }
+
+  std::string bytes(size_t n) {
+    need(n);
+    std::string s(p_, n);
+    p_ += n;
+    return s;
+  }
+};
+
+void put_u64(std::string& buf, uint64_t x) {
+  for (int i = 7; i >= 0; --i) {
+    buf += static_cast<char>((x >> (8 * i)) & 0xff);
+  }
+}
+
+}
+
+PqReplication::PqReplication(const std::vector<std::string>& keys, const std::vector<std::string>& values,
+                             bool check_interrupts) :
+  pConnPtr_(new DbConnection(keys, values, check_interrupts)),
+  streaming_(false),
+  xact_lsn_(0),
+  committed_lsn_(0),
+  returned_lsn_(0),
+  flushed_lsn_(0),
+  wal_end_(0)
+{
+  pConn_ = pConnPtr_->conn();
+}
+
+PqReplication::~PqReplication() {
+  try {
+    stop();
+  } catch (...) {}
+}
+
+// Publics /////////////////////////////////////////////////////////////////////
+
+void PqReplication::create_slot(const std::string& slot, bool temporary) {
+  char* ident = PQescapeIdentifier(pConn_, slot.c_str(), slot.size());
+  if (ident == NULL)
+    DbConnection::conn_stop(pConn_, "Failed to create replication slot");
+  std::string sql = std::string("CREATE_REPLICATION_SLOT ") + ident +
+    (temporary ? " TEMPORARY" : "") + " LOGICAL pgoutput";
+  PQfreemem(ident);
+
+  LOG_DEBUG << sql;
+
+  PGresult* pRes = PQexec(pConn_, sql.c_str());
+  ExecStatusType status = PQresultStatus(pRes);
+  PQclear(pRes);
+  if (status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK)
+    DbConnection::conn_stop(pConn_, "Failed to create replication slot");
+}
+
+void PqReplication::start(const std::string& slot, const std::vector<std::string>& publications,
+                          const std::string& start_lsn) {
+  if (streaming_)
+    cpp11::stop("Replication has already been started.");
+
+  // publication_names is a string with a comma-separated list of identifiers
+  std::string names;
+  for (size_t i = 0; i < publications.size(); ++i) {
+    char* ident = PQescapeIdentifier(pConn_, publications[i].c_str(), publications[i].size());
+    if (ident == NULL)
+      DbConnection::conn_stop(pConn_, "Failed to start replication");
+    if (i > 0) names += ",";
+    names += ident;
+    PQfreemem(ident);
+  }
+
+  char* slot_ident = PQescapeIdentifier(pConn_, slot.c_str(), slot.size());
+  char* names_literal = PQescapeLiteral(pConn_, names.c_str(), names.size());
+  if (slot_ident == NULL || names_literal == NULL) {
+    PQfreemem(slot_ident);
+    PQfreemem(names_literal);
+    DbConnection::conn_stop(pConn_, "Failed to start replication");
+  }
+
+  uint64_t lsn = parse_lsn(start_lsn);
+  std::string sql = std::string("START_REPLICATION SLOT ") + slot_ident + " LOGICAL " +
+    format_lsn(lsn) + " (proto_version '1', publication_names " + names_literal + ")";
+  PQfreemem(slot_ident);
+  PQfreemem(names_literal);
+
+  LOG_DEBUG << sql;
+
+  PGresult* pRes = PQexec(pConn_, sql.c_str());
+  ExecStatusType status = PQresultStatus(pRes);
+  PQclear(pRes);
+  if (status != PGRES_COPY_BOTH)
+    DbConnection::conn_stop(pConn_, "Failed to start replication");
+
+  streaming_ = true;
+  returned_lsn_ = flushed_lsn_ = wal_end_ = lsn;
+}
+
+void PqReplication::stop() {
+  if (!streaming_)
+    return;
+
+  streaming_ = false;
+  send_feedback(false);
+  PQputCopyEnd(pConn_, NULL);
+  DbConnection::finish_query(pConn_);
+}
+
+cpp11::list PqReplication::read(int timeout_ms, size_t max_changes) {
+  if (!streaming_)
+    cpp11::stop("Replication has not been started or has ended.");
+
+  typedef std::chrono::steady_clock clock;
+  clock::time_point deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+
+  while (committed_.size() < max_changes) {
+    char* buf = NULL;
+    int len = PQgetCopyData(pConn_, &buf, 1);
+
+    if (len > 0) {
+      try {
+        process_message(buf, len);
+      } catch (...) {
+        PQfreemem(buf);
+        throw;
+      }
+      PQfreemem(buf);
+      continue;
+    }
+
+    if (len == -2)
+      DbConnection::conn_stop(pConn_, "Failed to read replication stream");
+
+    if (len == -1) {
+      // The server has ended the stream
+      streaming_ = false;
+      PGresult* pRes = PQgetResult(pConn_);
+      ExecStatusType status = PQresultStatus(pRes);
+      PQclear(pRes);
+      DbConnection::finish_query(pConn_);
+      if (status != PGRES_COMMAND_OK)
+        DbConnection::conn_stop(pConn_, "Replication stream ended");
+      break;
+    }
+
+    int remaining = static_cast<int>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count()
+    );
+    if (remaining <= 0)
+      break;
+
+    std::vector<int> sockets(1, PQsocket(pConn_));
+    std::vector<bool> ready;
+    pq_poll_sockets(sockets, ready, remaining, false, 100);
+
+    if (!PQconsumeInput(pConn_))
+      DbConnection::conn_stop(pConn_, "Failed to read replication stream");
+  }
+
+  cpp11::list batches = make_batches();
+  if (streaming_)
+    send_feedback(false);
+  return batches;
+}
+
+// The server may remove the WAL up to `lsn`, and won't send changes that
+// have been committed before
+void PqReplication::acknowledge(uint64_t lsn) {
+  if (lsn > returned_lsn_)
+    cpp11::stop("Can't acknowledge changes that haven't been read yet.");
+
+  if (lsn > flushed_lsn_)
+    flushed_lsn_ = lsn;
+  if (streaming_)
+    send_feedback(false);
+}
+
+cpp11::list PqReplication::info() const {
+  using namespace cpp11::literals;
+
+  return cpp11::writable::list({
+    "streaming"_nm = streaming_,
+    "read_lsn"_nm = format_lsn(returned_lsn_),
+    "flushed_lsn"_nm = format_lsn(flushed_lsn_),
+    "server_lsn"_nm = format_lsn(wal_end_),
+    "pending"_nm = static_cast<double>(pending_.size() + committed_.size())
+  });
+}
+
+uint64_t PqReplication::parse_lsn(const std::string& lsn) {
+  unsigned int hi, lo;
+  char rest;
+  if (sscanf(lsn.c_str(), "%X/%X%c", &hi, &lo, &rest) != 2)
+    cpp11::stop("Invalid LSN: %s", lsn.c_str());
+  return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+std::string PqReplication::format_lsn(uint64_t lsn) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%X/%X", static_cast<unsigned int>(lsn >> 32),
+           static_cast<unsigned int>(lsn & 0xffffffff));
+  return buf;
+}
+
+// Privates ////////////////////////////////////////////////////////////////////
+
+// A CopyData message of the streaming replication protocol
+void PqReplication::process_message(const char* data, size_t len) {
+  const char* p = data;
+  MessageReader msg(p, data + len);
+
+  switch (msg.u8()) {
+  case 'w': {
+    // XLogData: start, end of WAL on the server, send time, payload
+    msg.u64();
+    uint64_t wal_end = msg.u64();
+    msg.u64();
+    if (wal_end > wal_end_)
+      wal_end_ = wal_end;
+    process_pgoutput(p, data + len - p);
+    break;
+  }
+
+  case 'k': {
+    // Keepalive: end of WAL on the server, send time, reply requested
+    uint64_t wal_end = msg.u64();
+    msg.u64();
+    bool reply = msg.u8() != 0;
+    if (wal_end > wal_end_)
+      wal_end_ = wal_end;
+
+    // Nothing is outstanding: the WAL up to here contains no changes
+    // for us, the slot may advance
+    if (pending_.empty() && committed_.empty() && flushed_lsn_ == returned_lsn_ &&
+        wal_end_ > returned_lsn_) {
+      returned_lsn_ = flushed_lsn_ = wal_end_;
+    }
+
+    if (reply)
+      send_feedback(true);
+    break;
+  }
+
+  default:
+    LOG_DEBUG << "unknown message " << data[0];
+  }
+}
+
+// A message of the pgoutput plugin (protocol version 1)
+void PqReplication::process_pgoutput(const char* data, size_t len) {
+  const char* p = data;
+  const char* end = data + len;
+  MessageReader msg(p, end);
+
+  char type = static_cast<char>(msg.u8());
+  switch (type) {
+  case 'B':
+    // Begin: final LSN, commit time, xid
+    xact_lsn_ = msg.u64();
+    pending_.clear();
+    break;
+
+  case 'C':
+    // Commit: flags, commit LSN, end LSN, commit time
+    msg.u8();
+    msg.u64();
+    committed_lsn_ = msg.u64();
+    committed_.insert(committed_.end(), pending_.begin(), pending_.end());
+    pending_.clear();
+
+    // Transactions without changes for us can be confirmed right away
+    if (committed_.empty() && flushed_lsn_ == returned_lsn_)
+      returned_lsn_ = flushed_lsn_ = committed_lsn_;
+    break;
+
+  case 'R': {
+    RelationPtr relation(new Relation);
+    Oid oid = msg.u32();
+    relation->schema = msg.str();
+    relation->name = msg.str();
+    msg.u8();
+    int n = msg.u16();
+    for (int i = 0; i < n; ++i) {
+      relation->key.push_back((msg.u8() & 1) != 0);
+      relation->columns.push_back(msg.str());
+      relation->types.push_back(msg.u32());
+      msg.u32();
+    }
+    relations_[oid] = relation;
+    break;
+  }
+
+  case 'I':
+  case 'U':
+  case 'D': {
+    Change change;
+    change.relation = find_relation(msg.u32());
+    change.op = type;
+    change.lsn = xact_lsn_;
+
+    char kind = static_cast<char>(msg.u8());
+    if (type == 'U' && (kind == 'K' || kind == 'O')) {
+      // The old values of the key or the row precede the new row, they
+      // are only sent if the key has changed or with REPLICA IDENTITY FULL
+      read_tuple(p, end, change.old_values);
+      kind = static_cast<char>(msg.u8());
+    }
+    bool old_tuple = (kind == 'K' || kind == 'O');
+    if (type == 'D' ? !old_tuple : kind != 'N')
+      cpp11::stop("Malformed replication message");
+
+    // Deletes carry the key or the old row, other columns are NULL
+    read_tuple(p, end, change.values);
+
+    if (type == 'D') {
+      change.old_values = change.values;
+    } else if (type == 'U' && change.old_values.empty()) {
+      // The key is unchanged
+      change.old_values = change.values;
+    }
+
+    size_t ncols = change.relation->columns.size();
+    if (change.values.size() != ncols || (!change.old_values.empty() && change.old_values.size() != ncols))
+      cpp11::stop("Malformed replication message");
+    pending_.push_back(change);
+    break;
+  }
+
+  case 'T': {
+    // Truncate: number of relations, options, relation OIDs
+    int n = msg.u32();
+    msg.u8();
+    for (int i = 0; i < n; ++i) {
+      Change change;
+      change.relation = find_relation(msg.u32());
+      change.op = 'T';
+      change.lsn = xact_lsn_;
+      Value null_value = { true, false, std::string() };
+      change.values.assign(change.relation->columns.size(), null_value);
+      pending_.push_back(change);
+    }
+    break;
+  }
+
+  default:
+    // Origin, type and logical decoding messages carry no changes
+    LOG_DEBUG << "skipping pgoutput message " << type;
+  }
+}
+
+// TupleData: number of columns, followed by a kind and data for each
+// column. Unchanged TOASTed values are not sent, they become NULL and are
+// marked as unchanged.
+void PqReplication::read_tuple(const char*& p, const char* end, std::vector<Value>& values) {
+  MessageReader msg(p, end);
+
+  int n = msg.u16();
+  values.resize(n);
+  for (int i = 0; i < n; ++i) {
+    char kind = static_cast<char>(msg.u8());
+    values[i].unchanged = (kind == 'u');
+    if (kind == 't' || kind == 'b') {
+      values[i].is_null = false;
+      values[i].text = msg.bytes(msg.u32());
+    } else {
+      values[i].is_null = true;
+      values[i].text.clear();
+    }
+  }
+}
+
+PqReplication::RelationPtr PqReplication::find_relation(Oid oid) const {
+  std::map<Oid, RelationPtr>::const_iterator it = relations_.find(oid);
+  if (it == relations_.end())
+    cpp11::stop("Unknown relation %u in replication stream", oid);
+  return it->second;
+}
+
+// Standby status update: written, flushed and applied position, time,
+// no reply requested. A keepalive that requests a reply is answered
+// right away, otherwise the server disconnects after wal_sender_timeout.
+void PqReplication::send_feedback(bool reply_requested) {
+  LOG_VERBOSE << reply_requested;
+
+  int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::system_clock::now().time_since_epoch()
+  ).count() - postgres_epoch_secs * 1000000;
+
+  std::string buf("r");
+  put_u64(buf, returned_lsn_);
+  put_u64(buf, flushed_lsn_);
+  put_u64(buf, flushed_lsn_);
+  put_u64(buf, static_cast<uint64_t>(now_us));
+  buf += '\0';
+
+  if (PQputCopyData(pConn_, buf.data(), static_cast<int>(buf.size())) != 1 || PQflush(pConn_) != 0)
+    DbConnection::conn_stop(pConn_, "Failed to send replication status");
+}
+
+// The committed changes as a list of batches, one per relation
+// (in the order of the first change), with text columns
+cpp11::list PqReplication::make_batches() {
+  using namespace cpp11::literals;
+
+  std::vector<RelationPtr> order;
+  std::map<Relation*, std::vector<size_t> > rows;
+  for (size_t i = 0; i < committed_.size(); ++i) {
+    Relation* relation = committed_[i].relation.get();
+    if (rows.find(relation) == rows.end())
+      order.push_back(committed_[i].relation);
+    rows[relation].push_back(i);
+  }
+
+  cpp11::writable::list batches(order.size());
+  for (size_t b = 0; b < order.size(); ++b) {
+    const Relation& relation = *order[b];
+    const std::vector<size_t>& idx = rows[order[b].get()];
+    R_xlen_t n = idx.size();
+    size_t p = relation.columns.size();
+
+    cpp11::writable::strings lsn(n), op(n);
+    cpp11::writable::list columns(p), old_columns(p), unchanged(p);
+    cpp11::writable::logicals key(p);
+    for (size_t j = 0; j < p; ++j) {
+      key[j] = relation.key[j];
+      columns[j] = cpp11::writable::strings(n);
+      unchanged[j] = cpp11::writable::logicals(n);
+      // Only the replica identity is sent for the previous row
+      if (relation.key[j])
+        old_columns[j] = cpp11::writable::strings(n);
+    }
+
+    for (R_xlen_t i = 0; i < n; ++i) {
+      const Change& change = committed_[idx[i]];
+      lsn[i] = format_lsn(change.lsn);
+      op[i] = (change.op == 'I') ? "insert" : (change.op == 'U') ? "update" :
+        (change.op == 'D') ? "delete" : "truncate";
+
+      for (size_t j = 0; j < p; ++j) {
+        const Value& value = change.values[j];
+        SET_STRING_ELT(columns[j], i, make_string(value));
+        LOGICAL(unchanged[j])[i] = value.unchanged;
+
+        if (relation.key[j]) {
+          SEXP x = change.old_values.empty() ? NA_STRING : make_string(change.old_values[j]);
+          SET_STRING_ELT(old_columns[j], i, x);
+        }
+      }
+    }
+
+    cpp11::writable::doubles types(p);
+    for (size_t j = 0; j < p; ++j) {
+      types[j] = relation.types[j];
+    }
+
+    batches[b] = cpp11::writable::list({
+      "schema"_nm = relation.schema,
+      "table"_nm = relation.name,
+      "names"_nm = relation.columns,
+      "types"_nm = types,
+      "key"_nm = key,
+      "lsn"_nm = lsn,
+      "op"_nm = op,
+      "columns"_nm = columns,
+      "old_columns"_nm = old_columns,
+      "unchanged"_nm = unchanged
+    });
+  }
+
+  returned_lsn_ = std::max(returned_lsn_, committed_.empty() ? returned_lsn_ : committed_lsn_);
+  committed_.clear();
+
+  return batches;
+}
+
+SEXP PqReplication::make_string(const Value& value) {
+  if (value.is_null)
+    return NA_STRING;
+  return Rf_mkCharLenCE(value.text.data(), static_cast<int>(value.text.size()), CE_UTF8);
+}
@@ -0,0 +1,102 @@
+#ifndef __RPOSTGRES_PQ_REPLICATION__
+#define __RPOSTGRES_PQ_REPLICATION__
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <chrono>
+#include <map>
+#include "DbConnection.h"
+
+class PqReplication;
+typedef boost::shared_ptr<PqReplication> PqReplicationPtr;
+
+// PqReplication ---------------------------------------------------------------
+
+// Consumes a logical replication slot with the pgoutput plugin on a
+// dedicated connection opened with replication=database. The messages of
+// the stream are decoded as they arrive: inserts, updates, deletes and
+// truncates are collected per transaction and handed out once the
+// transaction has been committed, grouped into one batch of text columns
+// per relation. Updates and deletes come with the previous values of the
+// replica identity, unchanged TOASTed values are marked separately. The position up to which the changes have been processed
+// is reported to the server with acknowledge().
+
+class PqReplication : boost::noncopyable {
+  struct Relation {
+    std::string schema;
+    std::string name;
+    std::vector<std::string> columns;
+    std::vector<Oid> types;
+    // Columns of the replica identity, all columns with REPLICA IDENTITY FULL
+    std::vector<bool> key;
+  };
+  typedef boost::shared_ptr<Relation> RelationPtr;
+
+  struct Value {
+    bool is_null;
+    // Unchanged TOASTed value of an update, not sent by the server
+    bool unchanged;
+    std::string text;
+  };
+
+  struct Change {
+    RelationPtr relation;
+    char op;
+    uint64_t lsn;
+    std::vector<Value> values;
+    // Replica identity before an update or delete, empty otherwise
+    std::vector<Value> old_values;
+  };
+
+  DbConnectionPtr pConnPtr_;
+  PGconn* pConn_;
+  bool streaming_;
+
+  // Relations by OID, a new entry replaces the previous one when the
+  // server announces a change of a relation
+  std::map<Oid, RelationPtr> relations_;
+
+  // Changes of the current transaction, and of committed transactions that
+  // haven't been returned yet
+  std::vector<Change> pending_;
+  std::vector<Change> committed_;
+  uint64_t xact_lsn_;
+  uint64_t committed_lsn_;
+
+  // End of the last transaction returned by read(), end of the last
+  // transaction acknowledged, and end of the WAL seen on the server
+  uint64_t returned_lsn_;
+  uint64_t flushed_lsn_;
+  uint64_t wal_end_;
+
+public:
+  PqReplication(const std::vector<std::string>& keys, const std::vector<std::string>& values,
+                bool check_interrupts);
+  ~PqReplication();
+
+public:
+  void create_slot(const std::string& slot, bool temporary);
+  void start(const std::string& slot, const std::vector<std::string>& publications,
+             const std::string& start_lsn);
+  void stop();
+
+  // Waits at most `timeout_ms` for changes, returns early once
+  // `max_changes` committed changes are available
+  cpp11::list read(int timeout_ms, size_t max_changes);
+  void acknowledge(uint64_t lsn);
+  cpp11::list info() const;
+
+  static uint64_t parse_lsn(const std::string& lsn);
+  static std::string format_lsn(uint64_t lsn);
+
+private:
+  void process_message(const char* data, size_t len);
+  void process_pgoutput(const char* data, size_t len);
+  void read_tuple(const char*& p, const char* end, std::vector<Value>& values);
+  RelationPtr find_relation(Oid oid) const;
+  void send_feedback(bool reply_requested);
+  cpp11::list make_batches();
+  static SEXP make_string(const Value& value);
+};
+
+#endif // __RPOSTGRES_PQ_REPLICATION__
@@ -6,17 +6,28 @@
 
 // Construction ////////////////////////////////////////////////////////////////
 
-PqResult::PqResult(const DbConnectionPtr& pConn, const std::string& sql, const bool immediate) :
+PqResult::PqResult(const DbConnectionPtr& pConn, const std::string& sql, const bool immediate, const bool async,
+                   const int cursor_rows) :
   DbResult(pConn)
 {
-  impl.reset(new DbResultImpl(pConn, sql, immediate));
+  impl.reset(new DbResultImpl(pConn, sql, immediate, async, cursor_rows));
 }
 
 
 // Publics /////////////////////////////////////////////////////////////////////
 
 DbResult* PqResult::create_and_send_query(const DbConnectionPtr& con, const std::string& sql, const bool immediate) {
-  return new PqResult(con, sql, immediate);
+  return new PqResult(con, sql, immediate, false, 0);
+}
+
+// The query is sent by the first call to bind()
+DbResult* PqResult::create_async(const DbConnectionPtr& con, const std::string& sql, const bool immediate) {
+  return new PqResult(con, sql, immediate, true, 0);
+}
+
+// The rows are fetched from a server-side cursor, `cursor_rows` at a time
+DbResult* PqResult::create_cursor(const DbConnectionPtr& con, const std::string& sql, const int cursor_rows) {
+  return new PqResult(con, sql, false, false, cursor_rows);
 }
 
 
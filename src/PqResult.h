@@ -9,10 +9,13 @@
 
 class PqResult : public DbResult {
 protected:
-  PqResult(const DbConnectionPtr& pConn, const std::string& sql, const bool immediate);
+  PqResult(const DbConnectionPtr& pConn, const std::string& sql, const bool immediate, const bool async,
+           const int cursor_rows);
 
 public:
   static DbResult* create_and_send_query(const DbConnectionPtr& con, const std::string& sql, const bool immediate);
+  static DbResult* create_async(const DbConnectionPtr& con, const std::string& sql, const bool immediate);
+  static DbResult* create_cursor(const DbConnectionPtr& con, const std::string& sql, const int cursor_rows);
 };
 
 #endif // __RPOSTGRES_PQ_RESULT__
@@ -0,0 +1,308 @@
+#include "pch.h"
+#include "PqResultCache.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+bool is_tag_char(char c) {
+  return isalnum(static_cast<unsigned char>(c)) || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+}
+
+bool is_ident_char(char c) {
+  return is_tag_char(c) || c == '$';
+}
+
+// Returns the position after the string literal that starts at `i`.
+// Doubled quotes are part of the literal, in E'...' strings a backslash
+// escapes the next character.
+size_t skip_string(const std::string& sql, size_t i, bool escapes) {
+  size_t n = sql.size();
+  for (size_t j = i + 1; j < n; ) {
+    if (escapes && sql[j] == '\\') {
+      j += 2;
+    } else if (sql[j] == '\'') {
+      if (j + 1 < n && sql[j + 1] == '\'')
+        j += 2;
+      else
+        return j + 1;
+    } else {
+      ++j;
+    }
+  }
+  return n;
+}
+
+// Returns the position after the token that starts at `i` and must be kept
+// as is: a literal, a quoted identifier, a dollar-quoted string or a
+// comment. Other characters are tokens of their own.
+size_t skip_token(const std::string& sql, size_t i) {
+  size_t n = sql.size();
+  char c = sql[i];
+  char next = (i + 1 < n) ? sql[i + 1] : '\0';
+
+  if (c == '\'') {
+    bool escapes = i > 0 && (sql[i - 1] == 'E' || sql[i - 1] == 'e') &&
+      (i < 2 || !is_ident_char(sql[i - 2]));
+    return skip_string(sql, i, escapes);
+  }
+
+  if (c == '"') {
+    size_t end = sql.find('"', i + 1);
+    return (end == std::string::npos) ? n : end + 1;
+  }
+
+  // The newline ends the comment, it is kept
+  if (c == '-' && next == '-') {
+    size_t end = sql.find('\n', i);
+    return (end == std::string::npos) ? n : end + 1;
+  }
+
+  // Block comments nest
+  if (c == '/' && next == '*') {
+    int depth = 0;
+    for (size_t j = i; j + 1 < n; ++j) {
+      if (sql[j] == '/' && sql[j + 1] == '*') {
+        ++depth;
+        ++j;
+      } else if (sql[j] == '*' && sql[j + 1] == '/') {
+        ++j;
+        if (--depth == 0)
+          return j + 1;
+      }
+    }
+    return n;
+  }
+
+  // $tag$...$tag$, the tag may be empty and doesn't start with a digit.
+  // $1 is a parameter, and $ can be part of an identifier.
+  if (c == '$' && (i == 0 || !is_ident_char(sql[i - 1])) &&
+      !isdigit(static_cast<unsigned char>(next))) {
+    size_t j = i + 1;
+    while (j < n && is_tag_char(sql[j]))
+      ++j;
+    if (j < n && sql[j] == '$') {
+      std::string tag = sql.substr(i, j - i + 1);
+      size_t end = sql.find(tag, j + 1);
+      return (end == std::string::npos) ? n : end + tag.size();
+    }
+  }
+
+  return i + 1;
+}
+
+}
+
+PqResultCache::PqResultCache() :
+  bytes_(0),
+  max_bytes_(0),
+  ttl_secs_(R_PosInf)
+{
+}
+
+// Publics /////////////////////////////////////////////////////////////////////
+
+void PqResultCache::configure(size_t max_bytes, double ttl_secs, const std::vector<std::string>& channels) {
+  max_bytes_ = max_bytes;
+  ttl_secs_ = ttl_secs;
+  channels_ = std::set<std::string>(channels.begin(), channels.end());
+
+  // Existing results keep their expiry time
+  evict();
+}
+
+bool PqResultCache::enabled() const {
+  return max_bytes_ > 0;
+}
+
+SEXP PqResultCache::get(const std::string& key) {
+  std::map<std::string, std::list<Entry>::iterator>::iterator it = index_.find(key);
+  if (it == index_.end())
+    return R_NilValue;
+
+  if (clock::now() >= it->second->expires) {
+    LOG_DEBUG << "expired";
+    erase(it->second);
+    return R_NilValue;
+  }
+
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->value;
+}
+
+void PqResultCache::put(const std::string& key, SEXP value) {
+  std::map<std::string, std::list<Entry>::iterator>::iterator it = index_.find(key);
+  if (it != index_.end()) {
+    erase(it->second);
+  }
+
+  size_t bytes = object_size(value) + key.size();
+  if (!enabled() || bytes > max_bytes_ || ttl_secs_ <= 0)
+    return;
+
+  Entry entry;
+  entry.key = key;
+  entry.value = value;
+  entry.bytes = bytes;
+  if (std::isfinite(ttl_secs_)) {
+    entry.expires = clock::now() +
+      std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(ttl_secs_));
+  } else {
+    entry.expires = clock::time_point::max();
+  }
+
+  entries_.push_front(entry);
+  index_[key] = entries_.begin();
+  bytes_ += bytes;
+
+  evict();
+}
+
+void PqResultCache::notify(const std::string& channel) {
+  if (channels_.count(channel) == 0)
+    return;
+
+  LOG_DEBUG << channel;
+  clear();
+}
+
+// The query text doesn't include the search path and the role, SET ROLE and
+// SET search_path are reported as SET
+void PqResultCache::command_done(const PGresult* pRes) {
+  static const char* const prefixes[] = { "SET", "RESET", "DISCARD" };
+
+  if (pRes == NULL || entries_.empty())
+    return;
+
+  const char* tag = PQcmdStatus(const_cast<PGresult*>(pRes));
+  for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); ++i) {
+    size_t len = strlen(prefixes[i]);
+    if (strncmp(tag, prefixes[i], len) == 0 && (tag[len] == '\0' || tag[len] == ' ')) {
+      LOG_DEBUG << tag;
+      clear();
+      return;
+    }
+  }
+}
+
+void PqResultCache::clear() {
+  entries_.clear();
+  index_.clear();
+  bytes_ = 0;
+}
+
+cpp11::list PqResultCache::info() const {
+  using namespace cpp11::literals;
+
+  return cpp11::list({
+    "size"_nm = static_cast<double>(max_bytes_),
+    "ttl"_nm = ttl_secs_,
+    "channels"_nm = cpp11::as_sexp(std::vector<std::string>(channels_.begin(), channels_.end())),
+    "entries"_nm = static_cast<int>(entries_.size()),
+    "bytes"_nm = static_cast<double>(bytes_)
+  });
+}
+
+std::string PqResultCache::make_key(const std::string& sql, const cpp11::list& params) {
+  std::string key;
+  key.reserve(sql.size() + 16);
+
+  // Runs of whitespace outside of literals, quoted identifiers and comments
+  // are equivalent to a single space
+  bool space = false;
+  for (size_t i = 0; i < sql.size(); ) {
+    if (isspace(static_cast<unsigned char>(sql[i]))) {
+      space = true;
+      ++i;
+      continue;
+    }
+    if (space && !key.empty())
+      key += ' ';
+    space = false;
+
+    size_t end = skip_token(sql, i);
+    key.append(sql, i, end - i);
+    i = end;
+  }
+
+  // Values are prefixed with their length, NULL is a distinct marker
+  char buf[32];
+  for (R_xlen_t i = 0; i < params.size(); ++i) {
+    SEXP param = params[i];
+    key += '\0';
+
+    if (TYPEOF(param) == VECSXP) {
+      for (R_xlen_t j = 0; j < Rf_xlength(param); ++j) {
+        SEXP value = VECTOR_ELT(param, j);
+        if (Rf_isNull(value)) {
+          key += "N;";
+        } else {
+          snprintf(buf, sizeof(buf), "B%lld:", static_cast<long long>(Rf_xlength(value)));
+          key += buf;
+          key.append(reinterpret_cast<const char*>(RAW(value)), Rf_xlength(value));
+        }
+      }
+    } else {
+      cpp11::strings values(param);
+      for (R_xlen_t j = 0; j < values.size(); ++j) {
+        SEXP value = values[j];
+        if (value == NA_STRING) {
+          key += "N;";
+        } else {
+          snprintf(buf, sizeof(buf), "S%d:", LENGTH(value));
+          key += buf;
+          key += CHAR(value);
+        }
+      }
+    }
+  }
+
+  return key;
+}
+
+// Privates ////////////////////////////////////////////////////////////////////
+
+void PqResultCache::erase(std::list<Entry>::iterator it) {
+  bytes_ -= it->bytes;
+  index_.erase(it->key);
+  entries_.erase(it);
+}
+
+void PqResultCache::evict() {
+  while (!entries_.empty() && bytes_ > max_bytes_) {
+    erase(--entries_.end());
+  }
+}
+
+// Approximate memory used by the columns of a data frame
+size_t PqResultCache::object_size(SEXP x) {
+  R_xlen_t n = Rf_xlength(x);
+
+  switch (TYPEOF(x)) {
+  case LGLSXP:
+  case INTSXP:
+    return n * sizeof(int);
+  case REALSXP:
+    return n * sizeof(double);
+  case RAWSXP:
+    return n;
+  case STRSXP: {
+    size_t size = n * sizeof(SEXP);
+    for (R_xlen_t i = 0; i < n; ++i) {
+      size += LENGTH(STRING_ELT(x, i));
+    }
+    return size;
+  }
+  case VECSXP: {
+    size_t size = n * sizeof(SEXP);
+    for (R_xlen_t i = 0; i < n; ++i) {
+      size += object_size(VECTOR_ELT(x, i));
+    }
+    return size;
+  }
+  default:
+    return sizeof(SEXP);
+  }
+}
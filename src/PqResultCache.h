@@ -0,0 +1,63 @@
+#ifndef __RPOSTGRES_PQ_RESULT_CACHE__
+#define __RPOSTGRES_PQ_RESULT_CACHE__
+
+#include <boost/noncopyable.hpp>
+#include <chrono>
+#include <list>
+#include <map>
+#include <set>
+
+// PqResultCache ---------------------------------------------------------------
+
+// Results of queries (as returned to R) by query text and parameters.
+// The least recently used results are evicted when the total size exceeds
+// the limit. Results expire after a fixed time, and all results are
+// discarded when a notification arrives on one of the configured channels,
+// or after a statement that may change the search path or the role.
+
+class PqResultCache : boost::noncopyable {
+  typedef std::chrono::steady_clock clock;
+
+  struct Entry {
+    std::string key;
+    cpp11::sexp value;
+    size_t bytes;
+    clock::time_point expires;
+  };
+
+  // Most recently used first
+  std::list<Entry> entries_;
+  std::map<std::string, std::list<Entry>::iterator> index_;
+  size_t bytes_;
+
+  size_t max_bytes_;
+  double ttl_secs_;
+  std::set<std::string> channels_;
+
+public:
+  PqResultCache();
+
+public:
+  void configure(size_t max_bytes, double ttl_secs, const std::vector<std::string>& channels);
+  bool enabled() const;
+
+  // Returns NULL if there is no valid result for the key
+  SEXP get(const std::string& key);
+  void put(const std::string& key, SEXP value);
+
+  void notify(const std::string& channel);
+  void command_done(const PGresult* pRes);
+  void clear();
+  cpp11::list info() const;
+
+  // Whitespace-normalized query text followed by the parameters,
+  // as passed to DbResult::bind()
+  static std::string make_key(const std::string& sql, const cpp11::list& params);
+
+private:
+  void erase(std::list<Entry>::iterator it);
+  void evict();
+  static size_t object_size(SEXP x);
+};
+
+#endif // __RPOSTGRES_PQ_RESULT_CACHE__
@@ -4,35 +4,45 @@
 #include "DbResult.h"
 #include "DbColumnStorage.h"
 #include "PqDataFrame.h"
+#include "PqPoll.h"
+#include "PqPrefetch.h"
 
-#ifdef _WIN32
-#include <winsock2.h>
-#define SOCKERR WSAGetLastError()
-#define SOCKET_EINTR WSAEINTR
-#else
-#include <errno.h>
-#define SOCKERR errno
-#define SOCKET_EINTR EINTR
-#endif
-
-PqResultImpl::PqResultImpl(const DbConnectionPtr& pConn, const std::string& sql, bool immediate) :
+// Name of the cursor in cursor mode, there is only one active result
+// per connection
+static const char* const cursor_name = "rpostgres_cursor";
+
+PqResultImpl::PqResultImpl(const DbConnectionPtr& pConn, const std::string& sql, bool immediate, bool async,
+                           int cursor_rows) :
   pConnPtr_(pConn),
   pConn_(pConn->conn()),
   sql_(sql),
   immediate_(immediate),
+  async_(async),
+  cursor_rows_(cursor_rows),
   pSpec_(NULL),
   complete_(false),
   ready_(false),
   data_ready_(false),
+  step_pending_(false),
   nrows_(0),
   rows_affected_(0),
   group_(0),
   groups_(0),
-  pRes_(NULL)
+  pRes_(NULL),
+  row_(0),
+  cursor_open_(false),
+  cursor_transaction_(false),
+  cursor_fetching_(false)
 {
 
   LOG_DEBUG << sql;
 
+  // Asynchronous queries are sent with the first call to bind(),
+  // the number of parameters is taken from the parameters supplied there
+  if (async_) {
+    return;
+  }
+
   prepare();
 
   try {
@@ -40,6 +50,8 @@ PqResultImpl::PqResultImpl(const DbConnectionPtr& pConn, const std::string& sql,
       bind();
     }
   } catch (...) {
+    // The result isn't owned by DbResult yet
+    close();
     PQclear(pSpec_);
     pSpec_ = NULL;
     throw;
@@ -59,6 +71,7 @@ PqResultImpl::~PqResultImpl() {
 
 PqResultImpl::_cache::_cache() :
   initialized_(false),
+  typnames_fixed_(false),
   ncols_(0),
   nparams_(0)
 {
@@ -245,6 +258,18 @@ void PqResultImpl::prepare() {
 
   pSpec_ = spec;
   cache.set(spec);
+
+  // The connection is idle until the query is sent, the names of
+  // user-defined types can't be looked up while the rows are streamed
+  std::vector<Oid> unknown;
+  for (size_t i = 0; i < cache.ncols_; ++i) {
+    if (!cache.known_[i]) {
+      unknown.push_back(cache.oids_[i]);
+    }
+  }
+  if (!unknown.empty()) {
+    pConnPtr_->resolve_types(unknown);
+  }
 }
 
 void PqResultImpl::init(bool params_have_rows) {
@@ -257,6 +282,48 @@ void PqResultImpl::init(bool params_have_rows) {
 
 // Publics /////////////////////////////////////////////////////////////////////
 
+// Called before the connection runs another query: discards the rows read
+// ahead, ends the cursor, and the transaction if it was started for the cursor.
+// Errors are ignored, this is part of the cleanup of the result.
+void PqResultImpl::close() {
+  if (pPrefetch_) {
+    pPrefetch_->stop();
+    pPrefetch_->clear();
+  }
+
+  if (!cursor_open_)
+    return;
+
+  LOG_DEBUG << cursor_transaction_;
+
+  cursor_open_ = false;
+  cursor_fetching_ = false;
+  complete_ = true;
+
+  // A batch that has been requested ahead of time is small, wait for it
+  // instead of cancelling the query, which would abort the transaction
+  DbConnection::finish_query(pConn_);
+
+  if (pRes_) {
+    PQclear(pRes_);
+    pRes_ = NULL;
+  }
+  row_ = 0;
+
+  std::string sql = cursor_transaction_ ? std::string("COMMIT") : std::string("CLOSE ") + cursor_name;
+  cursor_transaction_ = false;
+
+  PGresult* res = PQexec(pConn_, sql.c_str());
+  PQclear(res);
+}
+
+// Called before the connection is used for something else while the result
+// is still active, e.g. waiting for notifications
+void PqResultImpl::suspend() {
+  if (pPrefetch_)
+    pPrefetch_->stop();
+}
+
 bool PqResultImpl::complete() const {
   return complete_;
 }
@@ -267,6 +334,7 @@ int PqResultImpl::n_rows_fetched() {
 
 int PqResultImpl::n_rows_affected() {
   if (!ready_) return NA_INTEGER;
+  step_if_pending();
   if (cache.ncols_ > 0) return 0;
   return rows_affected_;
 }
@@ -274,10 +342,27 @@ int PqResultImpl::n_rows_affected() {
 void PqResultImpl::bind(const cpp11::list& params) {
   LOG_DEBUG << params.size();
 
+  // Rows read ahead belong to the previous parameters
+  if (pPrefetch_) {
+    pPrefetch_->stop();
+    pPrefetch_->clear();
+  }
+
   if (immediate_ && params.size() > 0) {
     cpp11::stop("Immediate query cannot be parameterized.");
   }
 
+  if (async_) {
+    if (ready_) {
+      cpp11::stop("Asynchronous query can only be bound once.");
+    }
+    cache.nparams_ = params.size();
+  }
+
+  if (cursor_rows_ > 0 && params.size() > 0 && Rf_length(params[0]) > 1) {
+    cpp11::stop("Cursor query can only be bound to one set of parameters.");
+  }
+
   if (params.size() != cache.nparams_) {
     cpp11::stop("Query requires %i params; %i supplied.",
          cache.nparams_, params.size());
@@ -310,6 +395,8 @@ cpp11::list PqResultImpl::fetch(const int n_max) {
   if (!ready_)
     cpp11::stop("Query needs to be bound before fetching");
 
+  step_if_pending();
+
   int n = 0;
   cpp11::list out;
 
@@ -318,11 +405,109 @@ cpp11::list PqResultImpl::fetch(const int n_max) {
   else
     out = peek_first_row();
 
+  resume();
   return out;
 }
 
+// Sends the statements of an unsent immediate query, and returns one data
+// frame per statement instead of combining them. The statements may return
+// different columns, the result of each statement is received as a whole.
+cpp11::list PqResultImpl::fetch_statements() {
+  LOG_DEBUG << sql_;
+
+  if (!immediate_ || !async_ || ready_)
+    cpp11::stop("Query has already been sent.");
+
+  if (!PQsendQuery(pConn_, sql_.c_str()))
+    conn_stop("Failed to send query");
+
+  ready_ = true;
+
+  std::vector<cpp11::sexp> frames;
+
+  for (;;) {
+    bool proceed = wait_for_data();
+    if (!proceed) {
+      pConnPtr_->cancel_query();
+      complete_ = true;
+      cpp11::stop("Interrupted.");
+    }
+
+    if (pRes_) {
+      PQclear(pRes_);
+      pRes_ = NULL;
+    }
+
+    pRes_ = PQgetResult(pConn_);
+    if (pRes_ == NULL)
+      break;
+
+    ExecStatusType status = PQresultStatus(pRes_);
+    if (status == PGRES_FATAL_ERROR) {
+      PQclear(pRes_);
+      pRes_ = NULL;
+      complete_ = true;
+      conn_stop("Failed to fetch row");
+    }
+
+    // The data of a COPY would have to be sent or received separately,
+    // the COPY fails and the remaining statements are skipped
+    if (status == PGRES_COPY_IN || status == PGRES_COPY_OUT || status == PGRES_COPY_BOTH) {
+      PQclear(pRes_);
+      pRes_ = NULL;
+      end_copy(status);
+      complete_ = true;
+      cpp11::stop("COPY is not supported when running several statements at once.");
+    }
+
+    cache = _cache();
+    cache.set(pRes_);
+
+    const int n = PQntuples(pRes_);
+    PqDataFrame data(this, cache.names_, n, cache.types_);
+    for (row_ = 0; row_ < n; ++row_) {
+      data.set_col_values();
+      data.advance();
+    }
+    row_ = 0;
+
+    nrows_ += n;
+    rows_affected_ += atoi(PQcmdTuples(pRes_));
+    pConnPtr_->command_done(pRes_);
+
+    cpp11::writable::list frame = data.get_data();
+    add_oids(frame);
+    frames.push_back(static_cast<SEXP>(frame));
+  }
+
+  complete_ = true;
+
+  cpp11::writable::list out(frames.size());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    out[i] = frames[i];
+  }
+  return out;
+}
+
+// Ends a COPY that has been started by one of several statements,
+// and discards the remaining results
+void PqResultImpl::end_copy(ExecStatusType status) {
+  if (status == PGRES_COPY_IN) {
+    PQputCopyEnd(pConn_, "COPY is not supported when running several statements at once");
+  } else {
+    pConnPtr_->cancel_query();
+
+    char* buf = NULL;
+    while (PQgetCopyData(pConn_, &buf, 0) > 0) {
+      PQfreemem(buf);
+    }
+  }
+  DbConnection::finish_query(pConn_);
+}
+
 cpp11::list PqResultImpl::get_column_info() {
   using namespace cpp11::literals;
+  step_if_pending();
   peek_first_row();
 
   cpp11::writable::strings names(cache.names_.size());
@@ -347,12 +532,58 @@ cpp11::list PqResultImpl::get_column_info() {
 
 // Publics (custom) ////////////////////////////////////////////////////////////
 
+// An asynchronous query is ready if the first result can be retrieved
+// without blocking
+bool PqResultImpl::is_ready() {
+  if (!step_pending_)
+    return true;
+
+  if (!PQconsumeInput(pConn_)) {
+    conn_stop("Failed to consume input from the server");
+  }
+
+  return !PQisBusy(pConn_);
+}
+
+int PqResultImpl::get_socket() const {
+  return PQsocket(pConn_);
+}
+
+// With a positive `max_bytes`, the rows are read in the background between
+// calls to fetch(), until they take up `max_bytes` bytes
+void PqResultImpl::set_prefetch(size_t max_bytes) {
+  if (cursor_rows_ > 0 && max_bytes > 0) {
+    cpp11::stop("Prefetching can't be combined with a cursor.");
+  }
+
+  suspend();
+  if (!pPrefetch_) {
+    pPrefetch_.reset(new PqPrefetcher(pConn_, pConnPtr_.get()));
+  }
+  pPrefetch_->set_max_bytes(max_bytes);
+  resume();
+}
 
 
 
 // Privates ////////////////////////////////////////////////////////////////////
 
 void PqResultImpl::set_params(const cpp11::list& params) {
+  // Lists are bound in binary format, check their elements up front
+  // so that no partial execution happens on invalid input
+  for (R_xlen_t i = 0; i < params.size(); ++i) {
+    if (TYPEOF(params[i]) != VECSXP)
+      continue;
+
+    cpp11::list param(params[i]);
+    for (R_xlen_t j = 0; j < param.size(); ++j) {
+      SEXP value = param[j];
+      if (!Rf_isNull(value) && TYPEOF(value) != RAWSXP) {
+        cpp11::stop("Lists must contain raw vectors or NULL");
+      }
+    }
+  }
+
   params_ = params;
 }
 
@@ -374,12 +605,12 @@ bool PqResultImpl::bind_row() {
   std::vector<int> lengths(cache.nparams_);
   for (int i = 0; i < cache.nparams_; ++i) {
     if (TYPEOF(params_[i]) == VECSXP) {
-      cpp11::list param(params_[i]);
-      if (!Rf_isNull(param[group_])) {
-        Rbyte* param_value = RAW(param[group_]);
-        c_params[i] = reinterpret_cast<const char*>(param_value);
+      // Binary format, points directly into the raw vector
+      SEXP param_value = VECTOR_ELT(params_[i], group_);
+      if (!Rf_isNull(param_value)) {
+        c_params[i] = reinterpret_cast<const char*>(RAW(param_value));
         formats[i] = 1;
-        lengths[i] = Rf_length(param[group_]);
+        lengths[i] = Rf_length(param_value);
       }
     }
     else {
@@ -393,6 +624,12 @@ bool PqResultImpl::bind_row() {
   // Pointer to first element of empty vector is undefined behavior!
   data_ready_ = false;
 
+  if (cursor_rows_ > 0) {
+    declare_cursor(c_params, lengths, formats);
+    send_cursor_fetch();
+    return true;
+  }
+
   if (immediate_) {
     int success = PQsendQuery(pConn_, sql_.c_str());
 
@@ -400,6 +637,19 @@ bool PqResultImpl::bind_row() {
       conn_stop("Failed to send query");
     }
   }
+  else if (async_) {
+    // No round trip for PQprepare(), the parameter types are inferred
+    // by the server in the same way
+    int success = PQsendQueryParams(
+      pConn_, sql_.c_str(), cache.nparams_, NULL,
+      cache.nparams_ ? &c_params[0] : NULL,
+      cache.nparams_ ? &lengths[0] : NULL,
+      cache.nparams_ ? &formats[0] : NULL,
+      0);
+
+    if (!success)
+      conn_stop("Failed to send query");
+  }
   else {
     int success = PQsendQueryPrepared(
       pConn_, "", cache.nparams_,
@@ -420,7 +670,14 @@ bool PqResultImpl::bind_row() {
 
 void PqResultImpl::after_bind(bool params_have_rows) {
   init(params_have_rows);
-  if (params_have_rows)
+  if (!params_have_rows)
+    return;
+
+  // Asynchronous queries don't wait for the first result here,
+  // only when it's needed
+  if (async_)
+    step_pending_ = true;
+  else
     step();
 }
 
@@ -447,6 +704,7 @@ cpp11::list PqResultImpl::fetch_rows(const int n_max, int& n) {
 
   LOG_VERBOSE << nrows_;
   cpp11::writable::list ret = data.get_data();
+  fix_typnames();
   add_oids(ret);
   return ret;
 }
@@ -454,10 +712,23 @@ cpp11::list PqResultImpl::fetch_rows(const int n_max, int& n) {
 void PqResultImpl::step() {
   LOG_VERBOSE;
 
+  if (cursor_rows_ > 0) {
+    step_cursor();
+    return;
+  }
+
   while (step_run())
     ;
 }
 
+void PqResultImpl::step_if_pending() {
+  if (!step_pending_)
+    return;
+
+  step_pending_ = false;
+  step();
+}
+
 bool PqResultImpl::step_run() {
   LOG_VERBOSE;
 
@@ -470,24 +741,14 @@ bool PqResultImpl::step_run() {
 
   LOG_VERBOSE << data_ready_;
 
-  // Check user interrupts while waiting for the data to be ready
   if (!data_ready_) {
     LOG_VERBOSE;
 
-    bool proceed = wait_for_data();
-
     data_ready_ = true;
-
-    if (!proceed) {
-      pConnPtr_->cancel_query();
-      complete_ = TRUE;
-      cpp11::stop("Interrupted.");
-    }
-
     need_cache_reset = true;
   }
 
-  pRes_ = PQgetResult(pConn_);
+  next_result();
 
   LOG_VERBOSE;
 
@@ -495,6 +756,12 @@ bool PqResultImpl::step_run() {
   if (PQresultStatus(pRes_) == PGRES_TUPLES_OK) {
     LOG_VERBOSE;
 
+    // Asynchronous queries have no prepared statement that describes
+    // the columns of an empty result
+    if (need_cache_reset && async_) {
+      cache.set(pRes_);
+    }
+
     step_done();
     return true;
   }
@@ -528,7 +795,63 @@ bool PqResultImpl::step_run() {
   return step_done();
 }
 
+// Takes the next result from the I/O thread while it runs,
+// otherwise from the connection
+void PqResultImpl::next_result() {
+  while (pPrefetch_) {
+    if (pPrefetch_->pop(pRes_)) {
+      // The thread has ended after the last row of the query,
+      // the connection is needed for what comes next
+      if (PQresultStatus(pRes_) != PGRES_SINGLE_TUPLE)
+        pPrefetch_->stop();
+      return;
+    }
+
+    if (!pPrefetch_->is_running())
+      break;
+
+    // Rows pushed just before the thread ended are popped next time
+    if (pPrefetch_->is_done()) {
+      pPrefetch_->stop();
+      continue;
+    }
+
+    const bool check_interrupts = pConnPtr_->is_check_interrupts();
+    if (pPrefetch_->wait(check_interrupts ? pConnPtr_->get_interrupt_latency() : 1000) || !check_interrupts)
+      continue;
+
+    try {
+      cpp11::check_user_interrupt();
+    }
+    catch (...) {
+      pPrefetch_->stop();
+      pConnPtr_->cancel_query();
+      complete_ = TRUE;
+      cpp11::stop("Interrupted.");
+    }
+  }
+
+  // Check user interrupts while waiting for the data to be ready,
+  // also while rows are streaming
+  bool proceed = wait_for_data();
+  if (!proceed) {
+    pConnPtr_->cancel_query();
+    complete_ = TRUE;
+    cpp11::stop("Interrupted.");
+  }
+
+  pRes_ = PQgetResult(pConn_);
+}
+
+// Continues reading rows in the background while R is busy
+void PqResultImpl::resume() {
+  if (pPrefetch_ && ready_ && !complete_ && !step_pending_)
+    pPrefetch_->start();
+}
+
 bool PqResultImpl::step_done() {
+  pConnPtr_->command_done(pRes_);
+
   char* tuples = PQcmdTuples(pRes_);
   LOG_VERBOSE << tuples;
   rows_affected_ += atoi(tuples);
@@ -541,11 +864,110 @@ bool PqResultImpl::step_done() {
 
   if (!more_params)
     complete_ = true;
+  else
+    resume();
 
   LOG_VERBOSE << "group: " << group_ << ", more_params: " << more_params;
   return more_params;
 }
 
+// In cursor mode, the rows arrive in batches of at most `cursor_rows_` rows,
+// `row_` is the current row in the batch. The next batch is requested
+// as soon as the current one has arrived, the server produces it
+// while the current batch is converted.
+void PqResultImpl::step_cursor() {
+  if (pRes_ && row_ + 1 < PQntuples(pRes_)) {
+    ++row_;
+    return;
+  }
+
+  if (pRes_) {
+    PQclear(pRes_);
+    pRes_ = NULL;
+  }
+  row_ = 0;
+
+  // The previous batch wasn't full, all rows have been returned
+  if (!cursor_fetching_) {
+    close();
+    return;
+  }
+
+  bool proceed = wait_for_data();
+  if (!proceed) {
+    pConnPtr_->cancel_query();
+    complete_ = true;
+    cpp11::stop("Interrupted.");
+  }
+
+  cursor_fetching_ = false;
+  pRes_ = PQgetResult(pConn_);
+
+  if (PQresultStatus(pRes_) != PGRES_TUPLES_OK) {
+    PQclear(pRes_);
+    pRes_ = NULL;
+    conn_stop("Failed to fetch row");
+  }
+
+  DbConnection::finish_query(pConn_);
+
+  int n = PQntuples(pRes_);
+  LOG_VERBOSE << n;
+
+  if (n == cursor_rows_) {
+    send_cursor_fetch();
+  }
+  else if (n == 0) {
+    PQclear(pRes_);
+    pRes_ = NULL;
+    close();
+  }
+}
+
+// Cursors only exist inside a transaction, a transaction is started
+// if the connection isn't in one already, and committed by close()
+void PqResultImpl::declare_cursor(const std::vector<const char*>& c_params, const std::vector<int>& lengths,
+                                  const std::vector<int>& formats) {
+  close();
+
+  if (PQtransactionStatus(pConn_) == PQTRANS_IDLE) {
+    PGresult* res = PQexec(pConn_, "BEGIN");
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+      PQclear(res);
+      conn_stop("Failed to start transaction for cursor");
+    }
+    PQclear(res);
+    cursor_transaction_ = true;
+  }
+  cursor_open_ = true;
+
+  std::string sql = std::string("DECLARE ") + cursor_name + " CURSOR FOR " + sql_;
+  LOG_DEBUG << sql;
+
+  PGresult* res = PQexecParams(
+    pConn_, sql.c_str(), cache.nparams_, NULL,
+    cache.nparams_ ? &c_params[0] : NULL,
+    cache.nparams_ ? &lengths[0] : NULL,
+    cache.nparams_ ? &formats[0] : NULL,
+    0);
+
+  if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+    PQclear(res);
+    conn_stop("Failed to declare cursor");
+  }
+  PQclear(res);
+}
+
+void PqResultImpl::send_cursor_fetch() {
+  char sql[64];
+  snprintf(sql, sizeof(sql), "FETCH FORWARD %d FROM %s", cursor_rows_, cursor_name);
+
+  if (!PQsendQuery(pConn_, sql))
+    conn_stop("Failed to fetch from cursor");
+
+  cursor_fetching_ = true;
+}
+
 cpp11::list PqResultImpl::peek_first_row() {
   PqDataFrame data(this, cache.names_, 1, cache.types_);
 
@@ -554,6 +976,7 @@ cpp11::list PqResultImpl::peek_first_row() {
   // Not calling data.advance(), remains a zero-row data frame
 
   cpp11::writable::list ret = data.get_data();
+  fix_typnames();
   add_oids(ret);
   return ret;
 }
@@ -566,6 +989,37 @@ void PqResultImpl::bind() {
   bind(cpp11::list());
 }
 
+// Columns of user-defined types get a class with the name of the type.
+// The names can't be looked up while the rows of an immediate or
+// asynchronous query are streamed. Columns whose type name isn't known
+// when the first rows are returned get no class for the whole result,
+// so that all chunks have the same classes.
+void PqResultImpl::fix_typnames() {
+  if (cache.typnames_fixed_)
+    return;
+  cache.typnames_fixed_ = true;
+
+  std::vector<Oid> unknown;
+  for (size_t i = 0; i < cache.ncols_; ++i) {
+    if (!cache.known_[i] && !pConnPtr_->has_typname(cache.oids_[i])) {
+      unknown.push_back(cache.oids_[i]);
+    }
+  }
+  if (unknown.empty())
+    return;
+
+  // The I/O thread owns the connection while it runs
+  if (!(pPrefetch_ && pPrefetch_->is_running())) {
+    pConnPtr_->resolve_types(unknown);
+  }
+  for (size_t i = 0; i < cache.ncols_; ++i) {
+    if (!cache.known_[i] && !pConnPtr_->has_typname(cache.oids_[i])) {
+      LOG_DEBUG << cache.oids_[i];
+      cache.known_[i] = true;
+    }
+  }
+}
+
 void PqResultImpl::add_oids(cpp11::writable::list& data) const {
   data.attr("oids") = cpp11::as_sexp(cache.oids_);
   data.attr("known") = cpp11::as_sexp(cache.known_);
@@ -583,65 +1037,40 @@ PGresult* PqResultImpl::get_result() {
   return pRes_;
 }
 
-// checks user interrupts while waiting for the first row of data to be ready
+int PqResultImpl::get_row() const {
+  return row_;
+}
+
+// checks user interrupts while waiting for data, at least every
+// `DbConnection::get_interrupt_latency()` milliseconds
 // see https://www.postgresql.org/docs/current/static/libpq-async.html
 // Returns `false` if an interrupt was detected
 bool PqResultImpl::wait_for_data() {
-  LOG_DEBUG << pConnPtr_->is_check_interrupts();
-
   if (!pConnPtr_->is_check_interrupts())
     return true;
 
-  // update db connection state using data available on the socket
-  if (!PQconsumeInput(pConn_)) {
-    cpp11::stop("Failed to consume input from the server");
-  }
-
-  // check if PQgetResult will block before waiting
-  if (!PQisBusy(pConn_)) {
+  // check if PQgetResult will block before waiting, this is cheap
+  // if the next row has already been received
+  if (!PQisBusy(pConn_))
     return true;
-  }
 
-  int socket, ret;
-  fd_set input;
-  FD_ZERO(&input);
+  LOG_DEBUG;
 
-  socket = PQsocket(pConn_);
-  if (socket < 0) {
-    cpp11::stop("Failed to get connection socket");
-  }
+  std::vector<int> sockets(1, PQsocket(pConn_));
+  const int latency_ms = pConnPtr_->get_interrupt_latency();
 
   do {
     LOG_DEBUG;
 
-    // wait for any traffic on the db connection socket but no longer than 1s
-    timeval timeout = {0, 0};
-    timeout.tv_sec = 1;
-    FD_SET(socket, &input);
-
-    const int nfds = socket + 1;
-    ret = select(nfds, &input, NULL, NULL, &timeout);
-    if (ret == 0) {
+    // wait for any traffic on the db connection socket,
+    // checking for user interrupts in between
+    std::vector<bool> ready;
+    try {
+      pq_poll_sockets(sockets, ready, -1, false, latency_ms);
+    }
+    catch (...) {
       LOG_DEBUG;
-
-      // timeout reached - check user interrupt
-      try {
-        // FIXME: Do we even need this?
-        cpp11::check_user_interrupt();
-      }
-      catch (...) {
-        LOG_DEBUG;
-        return false;
-      }
-    } else if (ret < 0) {
-      // caught interrupt in select()
-      if (SOCKERR == SOCKET_EINTR) {
-        LOG_DEBUG;
-        return false;
-      } else {
-        LOG_DEBUG;
-        cpp11::stop("select() failed with error code %d", SOCKERR);
-      }
+      return false;
     }
 
     // update db connection state using data available on the socket
@@ -3,11 +3,13 @@
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 #include "DbColumnDataType.h"
 #include "PqResultSource.h"
 
 class DbConnection;
 typedef boost::shared_ptr<DbConnection> DbConnectionPtr;
+class PqPrefetcher;
 
 class PqResultImpl : boost::noncopyable, public PqResultSource {
   // Back pointer
@@ -19,6 +21,8 @@ class PqResultImpl : boost::noncopyable, public PqResultSource {
   // Expression
   const std::string sql_;
   const bool immediate_;
+  const bool async_;
+  const int cursor_rows_;
 
   // Wrapped pointer
   PGresult* pSpec_;
@@ -30,6 +34,7 @@ class PqResultImpl : boost::noncopyable, public PqResultSource {
     std::vector<Oid> oids_;
     std::vector<DATA_TYPE> types_;
     std::vector<bool> known_;
+    bool typnames_fixed_;
     size_t ncols_;
     int nparams_;
 
@@ -47,14 +52,25 @@ class PqResultImpl : boost::noncopyable, public PqResultSource {
   bool complete_;
   bool ready_;
   bool data_ready_;
+  bool step_pending_;
   int nrows_;
   int rows_affected_;
   cpp11::list params_;
   int group_, groups_;
   PGresult* pRes_;
+  int row_;
+
+  // Cursor mode
+  bool cursor_open_;
+  bool cursor_transaction_;
+  bool cursor_fetching_;
+
+  // Rows read ahead in the background
+  boost::scoped_ptr<PqPrefetcher> pPrefetch_;
 
 public:
-  PqResultImpl(const DbConnectionPtr& pConn, const std::string& sql, bool immediate);
+  PqResultImpl(const DbConnectionPtr& pConn, const std::string& sql, bool immediate, bool async = false,
+               int cursor_rows = 0);
   ~PqResultImpl();
 
 private:
@@ -62,15 +78,23 @@ private:
   void init(bool params_have_rows);
 
 public:
-  void close() {} // FIXME
+  void close();
+  void suspend();
   bool complete() const;
   int n_rows_fetched();
   int n_rows_affected();
   void bind(const cpp11::list& params);
   cpp11::list fetch(const int n_max);
+  cpp11::list fetch_statements();
 
   cpp11::list get_column_info();
 
+  // Asynchronous queries
+  bool is_ready();
+  int get_socket() const;
+
+  void set_prefetch(size_t max_bytes);
+
 private:
   void set_params(const cpp11::list& params);
   bool bind_row();
@@ -78,8 +102,15 @@ private:
 
   cpp11::list fetch_rows(int n_max, int& n);
   void step();
+  void step_if_pending();
   bool step_run();
   bool step_done();
+  void next_result();
+  void resume();
+  void step_cursor();
+  void declare_cursor(const std::vector<const char*>& c_params, const std::vector<int>& lengths,
+                      const std::vector<int>& formats);
+  void send_cursor_fetch();
   cpp11::list peek_first_row();
 
 private:
@@ -87,11 +118,14 @@ private:
 
   void bind();
 
+  void fix_typnames();
+  void end_copy(ExecStatusType status);
   void add_oids(cpp11::writable::list& data) const;
 
 public:
   // PqResultSource
   PGresult* get_result();
+  int get_row() const;
 
 private:
   bool wait_for_data();
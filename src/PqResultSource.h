@@ -8,6 +8,7 @@ public:
 
 public:
   virtual PGresult* get_result() = 0;
+  virtual int get_row() const = 0;
 };
 
 #endif //RPOSTGRES_PQRESULTSOURCE_H
@@ -0,0 +1,67 @@
+#ifndef __RPOSTGRES_PQ_SPSC_QUEUE__
+#define __RPOSTGRES_PQ_SPSC_QUEUE__
+
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <vector>
+
+// PqSpscQueue -----------------------------------------------------------------
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. push() is only called by the producer, pop() only by the consumer.
+// Each index is written by one side only, the release/acquire pairs make the
+// element visible before the index that publishes it.
+
+template <class T>
+class PqSpscQueue : boost::noncopyable {
+  std::vector<T> buffer_;
+  std::atomic<size_t> head_; // next element to pop, written by the consumer
+  std::atomic<size_t> tail_; // next free slot, written by the producer
+
+public:
+  explicit PqSpscQueue(size_t capacity) :
+    buffer_(capacity + 1),
+    head_(0),
+    tail_(0)
+  {
+  }
+
+public:
+  // Returns false if the queue is full
+  bool push(const T& value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t next = advance(tail);
+    if (next == head_.load(std::memory_order_acquire))
+      return false;
+
+    buffer_[tail] = value;
+    tail_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Returns false if the queue is empty
+  bool pop(T& value) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+
+    value = buffer_[head];
+    head_.store(advance(head), std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+  bool full() const {
+    return advance(tail_.load(std::memory_order_acquire)) == head_.load(std::memory_order_acquire);
+  }
+
+private:
+  size_t advance(size_t i) const {
+    return (i + 1 == buffer_.size()) ? 0 : i + 1;
+  }
+};
+
+#endif // __RPOSTGRES_PQ_SPSC_QUEUE__
@@ -0,0 +1,136 @@
+#include "pch.h"
+#include "PqTypeCatalog.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+// Built-in types have fixed OIDs, they are known without a round trip
+static const struct {
+  Oid oid;
+  const char* typname;
+  char typtype;
+  Oid typelem;
+} builtin_types[] = {
+  {16, "bool", 'b', 0}, {17, "bytea", 'b', 0}, {18, "char", 'b', 0}, {19, "name", 'b', 18},
+  {20, "int8", 'b', 0}, {21, "int2", 'b', 0}, {23, "int4", 'b', 0}, {24, "regproc", 'b', 0},
+  {25, "text", 'b', 0}, {26, "oid", 'b', 0}, {27, "tid", 'b', 0}, {28, "xid", 'b', 0},
+  {29, "cid", 'b', 0}, {114, "json", 'b', 0}, {142, "xml", 'b', 0}, {600, "point", 'b', 701},
+  {601, "lseg", 'b', 600}, {602, "path", 'b', 0}, {603, "box", 'b', 600},
+  {604, "polygon", 'b', 0}, {628, "line", 'b', 701}, {650, "cidr", 'b', 0},
+  {700, "float4", 'b', 0}, {701, "float8", 'b', 0}, {705, "unknown", 'p', 0},
+  {718, "circle", 'b', 0}, {774, "macaddr8", 'b', 0}, {790, "money", 'b', 0},
+  {829, "macaddr", 'b', 0}, {869, "inet", 'b', 0}, {1042, "bpchar", 'b', 0},
+  {1043, "varchar", 'b', 0}, {1082, "date", 'b', 0}, {1083, "time", 'b', 0},
+  {1114, "timestamp", 'b', 0}, {1184, "timestamptz", 'b', 0}, {1186, "interval", 'b', 0},
+  {1266, "timetz", 'b', 0}, {1560, "bit", 'b', 0}, {1562, "varbit", 'b', 0},
+  {1700, "numeric", 'b', 0}, {2205, "regclass", 'b', 0}, {2206, "regtype", 'b', 0},
+  {2249, "record", 'p', 0}, {2278, "void", 'p', 0}, {2950, "uuid", 'b', 0},
+  {3220, "pg_lsn", 'b', 0}, {3614, "tsvector", 'b', 0}, {3615, "tsquery", 'b', 0},
+  {3802, "jsonb", 'b', 0}, {4072, "jsonpath", 'b', 0},
+  {143, "_xml", 'b', 142}, {199, "_json", 'b', 114}, {651, "_cidr", 'b', 650},
+  {1000, "_bool", 'b', 16}, {1001, "_bytea", 'b', 17}, {1005, "_int2", 'b', 21},
+  {1007, "_int4", 'b', 23}, {1009, "_text", 'b', 25}, {1014, "_bpchar", 'b', 1042},
+  {1015, "_varchar", 'b', 1043}, {1016, "_int8", 'b', 20}, {1021, "_float4", 'b', 700},
+  {1022, "_float8", 'b', 701}, {1028, "_oid", 'b', 26}, {1041, "_inet", 'b', 869},
+  {1115, "_timestamp", 'b', 1114}, {1182, "_date", 'b', 1082}, {1183, "_time", 'b', 1083},
+  {1185, "_timestamptz", 'b', 1184}, {1187, "_interval", 'b', 1186},
+  {1231, "_numeric", 'b', 1700}, {2951, "_uuid", 'b', 2950}, {3807, "_jsonb", 'b', 3802}
+};
+
+PqTypeCatalog::PqTypeCatalog() {
+  for (size_t i = 0; i < sizeof(builtin_types) / sizeof(builtin_types[0]); ++i) {
+    PqTypeInfo& info = types_[builtin_types[i].oid];
+    info.typname = builtin_types[i].typname;
+    info.typtype = builtin_types[i].typtype;
+    info.typbasetype = 0;
+    info.typelem = builtin_types[i].typelem;
+  }
+}
+
+PqTypeCatalogPtr PqTypeCatalog::get(PGconn* pConn) {
+  static std::map<std::string, PqTypeCatalogPtr> catalogs;
+
+  // The same host name can point to different servers, e.g. behind a load
+  // balancer or after a failover. The catalog is shared by the connections
+  // to the same database of the same server instance. The system identifier
+  // tells apart clusters, the start time restarts (e.g. after pg_upgrade).
+  std::ostringstream sql;
+  sql << "SELECT d.oid, pg_postmaster_start_time(), inet_server_addr(), inet_server_port()";
+  if (PQserverVersion(pConn) >= 90600) {
+    sql << ", CASE WHEN has_function_privilege('pg_catalog.pg_control_system()', 'EXECUTE') "
+           "THEN (SELECT system_identifier FROM pg_catalog.pg_control_system()) END";
+  }
+  sql << " FROM pg_database d WHERE d.datname = current_database()";
+
+  PGresult* pRes = PQexec(pConn, sql.str().c_str());
+  if (PQresultStatus(pRes) != PGRES_TUPLES_OK || PQntuples(pRes) != 1) {
+    // Not shared, built-in types are still known
+    LOG_INFO << PQresultErrorMessage(pRes);
+    PQclear(pRes);
+    return PqTypeCatalogPtr(new PqTypeCatalog());
+  }
+
+  std::ostringstream key;
+  for (int i = PQnfields(pRes) - 1; i >= 0; --i) {
+    key << PQgetvalue(pRes, 0, i) << "/";
+  }
+  PQclear(pRes);
+
+  PqTypeCatalogPtr& pCatalog = catalogs[key.str()];
+  if (!pCatalog) {
+    LOG_DEBUG << key.str();
+    pCatalog.reset(new PqTypeCatalog());
+  }
+  return pCatalog;
+}
+
+const PqTypeInfo* PqTypeCatalog::find(Oid oid) const {
+  std::map<Oid, PqTypeInfo>::const_iterator it = types_.find(oid);
+  if (it == types_.end())
+    return NULL;
+  return &it->second;
+}
+
+std::vector<Oid> PqTypeCatalog::missing(const std::vector<Oid>& oids) const {
+  std::vector<Oid> out;
+  for (size_t i = 0; i < oids.size(); ++i) {
+    if (types_.find(oids[i]) == types_.end() &&
+        std::find(out.begin(), out.end(), oids[i]) == out.end()) {
+      out.push_back(oids[i]);
+    }
+  }
+  return out;
+}
+
+// Adds the types to the catalog with one query on the connection,
+// which must be idle. Returns false if the query failed.
+bool PqTypeCatalog::fetch(PGconn* pConn, const std::vector<Oid>& oids) {
+  LOG_DEBUG << oids.size();
+
+  std::ostringstream sql;
+  sql << "SELECT oid, typname, typtype, typbasetype, typelem FROM pg_type WHERE oid IN (";
+  for (size_t i = 0; i < oids.size(); ++i) {
+    if (i > 0) sql << ", ";
+    sql << oids[i];
+  }
+  sql << ")";
+
+  PGresult* pRes = PQexec(pConn, sql.str().c_str());
+  bool ok = (PQresultStatus(pRes) == PGRES_TUPLES_OK);
+  if (ok) {
+    for (int i = 0; i < PQntuples(pRes); ++i) {
+      Oid oid = static_cast<Oid>(strtoul(PQgetvalue(pRes, i, 0), NULL, 10));
+      PqTypeInfo& info = types_[oid];
+      info.typname = PQgetvalue(pRes, i, 1);
+      info.typtype = PQgetvalue(pRes, i, 2)[0];
+      info.typbasetype = static_cast<Oid>(strtoul(PQgetvalue(pRes, i, 3), NULL, 10));
+      info.typelem = static_cast<Oid>(strtoul(PQgetvalue(pRes, i, 4), NULL, 10));
+    }
+  } else {
+    LOG_INFO << PQresultErrorMessage(pRes);
+  }
+  PQclear(pRes);
+
+  return ok;
+}
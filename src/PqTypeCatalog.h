@@ -0,0 +1,43 @@
+#ifndef __RPOSTGRES_PQ_TYPE_CATALOG__
+#define __RPOSTGRES_PQ_TYPE_CATALOG__
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <map>
+
+class PqTypeCatalog;
+typedef boost::shared_ptr<PqTypeCatalog> PqTypeCatalogPtr;
+
+// PqTypeInfo ------------------------------------------------------------------
+
+struct PqTypeInfo {
+  std::string typname;
+  char typtype;
+  Oid typbasetype;
+  Oid typelem;
+};
+
+// PqTypeCatalog ---------------------------------------------------------------
+
+// The entries of pg_type seen so far on a database. One catalog is shared by
+// all connections (including pooled ones) to the same database on the same
+// server instance, for the lifetime of the process. Built-in types are known upfront,
+// other types are added the first time their OID shows up in a result.
+
+class PqTypeCatalog : boost::noncopyable {
+  std::map<Oid, PqTypeInfo> types_;
+
+public:
+  PqTypeCatalog();
+
+  // Returns the catalog for the database of the connection,
+  // which must be idle
+  static PqTypeCatalogPtr get(PGconn* pConn);
+
+public:
+  const PqTypeInfo* find(Oid oid) const;
+  std::vector<Oid> missing(const std::vector<Oid>& oids) const;
+  bool fetch(PGconn* pConn, const std::vector<Oid>& oids);
+};
+
+#endif // __RPOSTGRES_PQ_TYPE_CATALOG__
@@ -1,6 +1,9 @@
 #include "pch.h"
 #include "PqUtils.h"
 
+#include <cerrno>
+#include <cstring>
+
 // From https://stackoverflow.com/a/40914871/946850:
 int days_from_civil(int y, int m, int d) {
   y -= m <= 2;
@@ -11,7 +14,27 @@ int days_from_civil(int y, int m, int d) {
   return era * 146097 + doe - 719468;
 }
 
+// Inverse of days_from_civil(), same source
+void civil_from_days(int z, int& y, int& m, int& d) {
+  z += 719468;
+  const int era = (z >= 0 ? z : z - 146096) / 146097;
+  const int doe = static_cast<unsigned>(z - era * 146097);              // [0, 146096]
+  const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; // [0, 399]
+  const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);              // [0, 365]
+  const int mp = (5 * doy + 2) / 153;                                   // [0, 11]
+  d = doy - (153 * mp + 2) / 5 + 1;                                     // [1, 31]
+  m = mp + (mp < 10 ? 3 : -9);                                          // [1, 12]
+  y = yoe + era * 400 + (m <= 2);
+}
+
 time_t tm_to_time_t(const tm& tm_) {
   const time_t days = days_from_civil(tm_.tm_year + 1900, tm_.tm_mon + 1, tm_.tm_mday);
   return days * 86400 + tm_.tm_hour * 60 * 60 + tm_.tm_min * 60 + tm_.tm_sec;
 }
+
+FILE* open_file(const std::string& path, const char* mode) {
+  FILE* file = fopen(path.c_str(), mode);
+  if (file == NULL)
+    cpp11::stop("Can't open file '%s': %s", path.c_str(), strerror(errno));
+  return file;
+}
@@ -1,7 +1,32 @@
 #ifndef __RPOSTGRES_MY_UTILS__
 #define __RPOSTGRES_MY_UTILS__
 
+#include <boost/noncopyable.hpp>
+#include <cstdio>
+
 int days_from_civil(int y, int m, int d);
+void civil_from_days(int z, int& y, int& m, int& d);
 time_t tm_to_time_t(const tm& tm_);
 
+// Opens a local file, fails with an error message that contains the path
+FILE* open_file(const std::string& path, const char* mode);
+
+// Closes the file when leaving the scope, also on errors
+class FileCloser : boost::noncopyable {
+  FILE* file_;
+
+public:
+  explicit FileCloser(FILE* file) : file_(file) {}
+  ~FileCloser() {
+    if (file_) fclose(file_);
+  }
+
+  // Reports errors that occur when flushing the file
+  int close() {
+    int ret = fclose(file_);
+    file_ = NULL;
+    return ret;
+  }
+};
+
 #endif
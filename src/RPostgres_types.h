@@ -4,7 +4,9 @@
 #define __RPOSTGRES_TYPES__
 
 #include "DbConnection.h"
+#include "DbConnectionPool.h"
 #include "DbResult.h"
+#include "PqReplication.h"
 
 namespace cpp11 {
 
@@ -16,6 +18,22 @@ enable_if_t<std::is_same<decay_t<T>, DbConnection*>::value, decay_t<T>> as_cpp(S
   return connection->get();
 }
 
+template <typename T>
+enable_if_t<std::is_same<decay_t<T>, DbConnectionPool*>::value, decay_t<T>> as_cpp(SEXP from) {
+  DbConnectionPoolPtr* pool = (DbConnectionPoolPtr*)(R_ExternalPtrAddr(from));
+  if (!pool)
+    stop("Invalid connection pool");
+  return pool->get();
+}
+
+template <typename T>
+enable_if_t<std::is_same<decay_t<T>, PqReplication*>::value, decay_t<T>> as_cpp(SEXP from) {
+  PqReplicationPtr* stream = (PqReplicationPtr*)(R_ExternalPtrAddr(from));
+  if (!stream)
+    stop("Invalid replication stream");
+  return stream->get();
+}
+
 template <typename T>
 enable_if_t<std::is_same<decay_t<T>, DbResult*>::value, decay_t<T>> as_cpp(SEXP from) {
   DbResult* result = (DbResult*)(R_ExternalPtrAddr(from));
@@ -1,5 +1,9 @@
 #include "pch.h"
 #include "RPostgres_types.h"
+#include "PqQuote.h"
+#include "PqResultCache.h"
+#include "PqRelationCache.h"
+#include "PqLargeObject.h"
 
 
 [[cpp11::register]]
@@ -22,6 +26,37 @@ cpp11::external_pointer<DbConnectionPtr> connection_create(
   return cpp11::external_pointer<DbConnectionPtr>(pConn, true);
 }
 
+[[cpp11::register]]
+cpp11::list connection_create_many(
+  std::vector<std::string> keys,
+  std::vector<std::string> values,
+  int n,
+  std::string init_sql,
+  int timeout_ms,
+  bool check_interrupts
+) {
+  LOG_VERBOSE << n;
+
+  std::vector<PGconn*> conns;
+  std::vector<std::string> errors;
+  DbConnection::connect_parallel(keys, values, n, init_sql, timeout_ms, conns, errors);
+
+  // Failed connections are reported as error messages
+  cpp11::writable::list out(n);
+  for (int i = 0; i < n; ++i) {
+    if (conns[i] == NULL) {
+      out[i] = cpp11::as_sexp(errors[i].c_str());
+      continue;
+    }
+
+    DbConnectionPtr* pConn = new DbConnectionPtr(new DbConnection(conns[i], check_interrupts));
+    conns[i] = NULL;
+    out[i] = cpp11::external_pointer<DbConnectionPtr>(pConn, true);
+  }
+
+  return out;
+}
+
 [[cpp11::register]]
 bool connection_valid(cpp11::external_pointer<DbConnectionPtr> con_) {
   DbConnectionPtr* con = con_.get();
@@ -36,6 +71,17 @@ void connection_release(cpp11::external_pointer<DbConnectionPtr> con_) {
   }
 
   DbConnectionPtr* con = con_.get();
+
+  // Pooled connections are reset and kept open for the next checkout.
+  // The handle is invalidated first, also if the reset fails.
+  DbConnectionPool* pool = con->get()->get_pool();
+  if (pool) {
+    DbConnectionPtr pConn = *con;
+    con_.reset();
+    pool->release(pConn);
+    return;
+  }
+
   if (con->get()->has_query()) {
     cpp11::warning(std::string("There is a result object still in use.\n"
       "The connection will be automatically released when it is closed"));
@@ -45,37 +91,58 @@ void connection_release(cpp11::external_pointer<DbConnectionPtr> con_) {
   con_.reset();
 }
 
+[[cpp11::register]]
+void connection_set_interrupt_latency(DbConnection* con, int latency_ms) {
+  con->set_interrupt_latency(latency_ms);
+}
+
+// The `check_interrupts` argument that recreates the settings of the
+// connection: the latency in seconds, or 0 if interrupts aren't checked
+[[cpp11::register]]
+double connection_get_check_interrupts(DbConnection* con) {
+  if (!con->is_check_interrupts())
+    return 0;
+  return con->get_interrupt_latency() / 1000.0;
+}
+
 [[cpp11::register]]
 cpp11::list connection_info(DbConnection* con) {
   return con->info();
 }
 
-// Quoting
+[[cpp11::register]]
+cpp11::strings connection_conninfo(DbConnection* con) {
+  return con->conninfo();
+}
 
 [[cpp11::register]]
-cpp11::strings connection_quote_string(DbConnection* con, cpp11::strings xs) {
-  const auto n = xs.size();
-  cpp11::writable::strings output(n);
+cpp11::strings connection_parameter_status(DbConnection* con, std::string name) {
+  return con->parameter_status(name);
+}
 
-  for (R_xlen_t i = 0; i < n; ++i) {
-    auto x = xs[i];
-    output[i] = con->quote_string(x);
-  }
+[[cpp11::register]]
+cpp11::strings connection_typnames(DbConnection* con, std::vector<double> oids) {
+  return con->typnames(oids);
+}
+
+// Quoting
 
-  return output;
+[[cpp11::register]]
+cpp11::strings connection_quote_string(DbConnection* con, cpp11::strings xs, bool redshift) {
+  con->check_connection();
+  return PqQuoter(con->conn(), redshift).quote_strings(xs);
 }
 
 [[cpp11::register]]
 cpp11::strings connection_quote_identifier(DbConnection* con, cpp11::strings xs) {
-  const auto n = xs.size();
-  cpp11::writable::strings output(n);
-
-  for (R_xlen_t i = 0; i < n; ++i) {
-    auto x = xs[i];
-    output[i] = con->quote_identifier(x);
-  }
+  con->check_connection();
+  return PqQuoter(con->conn(), false).quote_identifiers(xs);
+}
 
-  return output;
+[[cpp11::register]]
+cpp11::strings connection_quote_literal(DbConnection* con, cpp11::sexp x, bool redshift) {
+  con->check_connection();
+  return PqQuoter(con->conn(), redshift).quote_literals(x);
 }
 
 // Transactions
@@ -97,11 +164,171 @@ void connection_copy_data(DbConnection* con, std::string sql, cpp11::list df) {
   return con->copy_data(sql, df);
 }
 
+[[cpp11::register]]
+double connection_copy_to_file(DbConnection* con, std::string sql, std::string path) {
+  con->check_connection();
+  return con->copy_to_file(sql, path);
+}
+
+[[cpp11::register]]
+void connection_insert_values(DbConnection* con, std::string prefix, cpp11::list df, bool redshift,
+                              double batch_bytes) {
+  con->check_connection();
+  con->insert_values(prefix, df, redshift, static_cast<size_t>(batch_bytes));
+}
+
+[[cpp11::register]]
+void connection_copy_data_parallel(cpp11::list cons, std::string sql, cpp11::list df) {
+  std::vector<DbConnection*> conns;
+  for (R_xlen_t i = 0; i < cons.size(); ++i) {
+    conns.push_back(cpp11::as_cpp<DbConnection*>(cons[i]));
+  }
+  DbConnection::copy_data_parallel(conns, sql, df);
+}
+
+// Result cache
+
+[[cpp11::register]]
+void connection_cache_configure(DbConnection* con, double max_bytes, double ttl_secs,
+                                std::vector<std::string> channels) {
+  con->result_cache().configure(static_cast<size_t>(max_bytes), ttl_secs, channels);
+}
+
+// Results are neither stored nor served in a transaction
+[[cpp11::register]]
+bool connection_cache_enabled(DbConnection* con) {
+  return con->result_cache().enabled() && PQtransactionStatus(con->conn()) == PQTRANS_IDLE;
+}
+
+[[cpp11::register]]
+cpp11::list connection_cache_info(DbConnection* con) {
+  return con->result_cache().info();
+}
+
+[[cpp11::register]]
+void connection_cache_clear(DbConnection* con) {
+  con->result_cache().clear();
+}
+
+// Returns NULL if the cache is disabled or has no valid result,
+// notifications that have arrived in the meantime are processed first
+[[cpp11::register]]
+cpp11::sexp connection_cache_get(DbConnection* con, std::string sql, cpp11::list params) {
+  PqResultCache& cache = con->result_cache();
+  if (!cache.enabled())
+    return R_NilValue;
+
+  con->consume_notifications();
+  return cache.get(PqResultCache::make_key(sql, params));
+}
+
+[[cpp11::register]]
+void connection_cache_put(DbConnection* con, std::string sql, cpp11::list params, cpp11::sexp value) {
+  PqResultCache& cache = con->result_cache();
+  if (!cache.enabled())
+    return;
+
+  cache.put(PqResultCache::make_key(sql, params), value);
+}
+
+// The status of the last completed statement, e.g. "SELECT 3"
+[[cpp11::register]]
+std::string connection_command_status(DbConnection* con) {
+  return con->command_status();
+}
+
+// Relation cache
+
+[[cpp11::register]]
+void connection_relations_configure(DbConnection* con, bool enabled, std::vector<std::string> channels) {
+  con->relation_cache().configure(enabled, channels);
+}
+
+[[cpp11::register]]
+cpp11::list connection_relations_info(DbConnection* con) {
+  return con->relation_cache().info();
+}
+
+// Returns NULL if the cache is disabled or needs to be loaded,
+// notifications that have arrived in the meantime are processed first
+[[cpp11::register]]
+cpp11::sexp connection_relations_get(DbConnection* con) {
+  PqRelationCache& cache = con->relation_cache();
+  if (!cache.enabled())
+    return R_NilValue;
+
+  con->consume_notifications();
+  return cache.get();
+}
+
+[[cpp11::register]]
+void connection_relations_put(DbConnection* con, cpp11::sexp value) {
+  con->relation_cache().put(value);
+}
+
+// Large objects
+
+[[cpp11::register]]
+cpp11::sexp connection_lo_read_raw(DbConnection* con, double oid, double offset, double length,
+                                   double chunk_size) {
+  cpp11::sexp out;
+  con->with_transaction([&]() {
+    out = PqLargeObject::read_raw(con->conn(), static_cast<Oid>(oid), static_cast<int64_t>(offset),
+                                  static_cast<int64_t>(length), static_cast<size_t>(chunk_size));
+  });
+  return out;
+}
+
+[[cpp11::register]]
+double connection_lo_read_file(DbConnection* con, double oid, double offset, double length,
+                               double chunk_size, std::string path) {
+  int64_t n = 0;
+  con->with_transaction([&]() {
+    n = PqLargeObject::read_file(con->conn(), static_cast<Oid>(oid), static_cast<int64_t>(offset),
+                                 static_cast<int64_t>(length), static_cast<size_t>(chunk_size), path);
+  });
+  return static_cast<double>(n);
+}
+
+[[cpp11::register]]
+double connection_lo_write_raw(DbConnection* con, cpp11::raws data, double chunk_size) {
+  Oid oid = InvalidOid;
+  con->with_transaction([&]() {
+    oid = PqLargeObject::write_raw(con->conn(), data, static_cast<size_t>(chunk_size));
+  });
+  return oid;
+}
+
+[[cpp11::register]]
+double connection_lo_write_file(DbConnection* con, std::string path, double chunk_size) {
+  Oid oid = InvalidOid;
+  con->with_transaction([&]() {
+    oid = PqLargeObject::write_file(con->conn(), path, static_cast<size_t>(chunk_size));
+  });
+  return oid;
+}
+
+[[cpp11::register]]
+void connection_lo_unlink(DbConnection* con, double oid) {
+  con->with_transaction([&]() {
+    PqLargeObject::unlink(con->conn(), static_cast<Oid>(oid));
+  });
+}
+
 [[cpp11::register]]
 cpp11::list connection_wait_for_notify(DbConnection* con, int timeout_secs) {
   return con->wait_for_notify(timeout_secs);
 }
 
+[[cpp11::register]]
+cpp11::list connection_wait_for_notifications(cpp11::list cons, int timeout_ms, int n_max) {
+  std::vector<DbConnection*> conns;
+  for (R_xlen_t i = 0; i < cons.size(); ++i) {
+    conns.push_back(cpp11::as_cpp<DbConnection*>(cons[i]));
+  }
+  return DbConnection::wait_for_notifications(conns, timeout_ms, n_max);
+}
+
 // Temporary Schema
 [[cpp11::register]]
 cpp11::strings connection_get_temp_schema(DbConnection* con) {
@@ -20,6 +20,13 @@ extern "C" SEXP _RPostgres_connection_create(SEXP keys, SEXP values, SEXP check_
   END_CPP11
 }
 // connection.cpp
+cpp11::list connection_create_many(std::vector<std::string> keys, std::vector<std::string> values, int n, std::string init_sql, int timeout_ms, bool check_interrupts);
+extern "C" SEXP _RPostgres_connection_create_many(SEXP keys, SEXP values, SEXP n, SEXP init_sql, SEXP timeout_ms, SEXP check_interrupts) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_create_many(cpp11::as_cpp<cpp11::decay_t<std::vector<std::string>>>(keys), cpp11::as_cpp<cpp11::decay_t<std::vector<std::string>>>(values), cpp11::as_cpp<cpp11::decay_t<int>>(n), cpp11::as_cpp<cpp11::decay_t<std::string>>(init_sql), cpp11::as_cpp<cpp11::decay_t<int>>(timeout_ms), cpp11::as_cpp<cpp11::decay_t<bool>>(check_interrupts)));
+  END_CPP11
+}
+// connection.cpp
 bool connection_valid(cpp11::external_pointer<DbConnectionPtr> con_);
 extern "C" SEXP _RPostgres_connection_valid(SEXP con_) {
   BEGIN_CPP11
@@ -35,6 +42,21 @@ extern "C" SEXP _RPostgres_connection_release(SEXP con_) {
   END_CPP11
 }
 // connection.cpp
+void connection_set_interrupt_latency(DbConnection* con, int latency_ms);
+extern "C" SEXP _RPostgres_connection_set_interrupt_latency(SEXP con, SEXP latency_ms) {
+  BEGIN_CPP11
+    connection_set_interrupt_latency(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<int>>(latency_ms));
+    return R_NilValue;
+  END_CPP11
+}
+// connection.cpp
+double connection_get_check_interrupts(DbConnection* con);
+extern "C" SEXP _RPostgres_connection_get_check_interrupts(SEXP con) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_get_check_interrupts(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con)));
+  END_CPP11
+}
+// connection.cpp
 cpp11::list connection_info(DbConnection* con);
 extern "C" SEXP _RPostgres_connection_info(SEXP con) {
   BEGIN_CPP11
@@ -42,10 +64,31 @@ extern "C" SEXP _RPostgres_connection_info(SEXP con) {
   END_CPP11
 }
 // connection.cpp
-cpp11::strings connection_quote_string(DbConnection* con, cpp11::strings xs);
-extern "C" SEXP _RPostgres_connection_quote_string(SEXP con, SEXP xs) {
+cpp11::strings connection_conninfo(DbConnection* con);
+extern "C" SEXP _RPostgres_connection_conninfo(SEXP con) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_conninfo(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con)));
+  END_CPP11
+}
+// connection.cpp
+cpp11::strings connection_parameter_status(DbConnection* con, std::string name);
+extern "C" SEXP _RPostgres_connection_parameter_status(SEXP con, SEXP name) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_parameter_status(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<std::string>>(name)));
+  END_CPP11
+}
+// connection.cpp
+cpp11::strings connection_typnames(DbConnection* con, std::vector<double> oids);
+extern "C" SEXP _RPostgres_connection_typnames(SEXP con, SEXP oids) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_typnames(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<std::vector<double>>>(oids)));
+  END_CPP11
+}
+// connection.cpp
+cpp11::strings connection_quote_string(DbConnection* con, cpp11::strings xs, bool redshift);
+extern "C" SEXP _RPostgres_connection_quote_string(SEXP con, SEXP xs, SEXP redshift) {
   BEGIN_CPP11
-    return cpp11::as_sexp(connection_quote_string(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<cpp11::strings>>(xs)));
+    return cpp11::as_sexp(connection_quote_string(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<cpp11::strings>>(xs), cpp11::as_cpp<cpp11::decay_t<bool>>(redshift)));
   END_CPP11
 }
 // connection.cpp
@@ -56,6 +99,13 @@ extern "C" SEXP _RPostgres_connection_quote_identifier(SEXP con, SEXP xs) {
   END_CPP11
 }
 // connection.cpp
+cpp11::strings connection_quote_literal(DbConnection* con, cpp11::sexp x, bool redshift);
+extern "C" SEXP _RPostgres_connection_quote_literal(SEXP con, SEXP x, SEXP redshift) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_quote_literal(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<cpp11::sexp>>(x), cpp11::as_cpp<cpp11::decay_t<bool>>(redshift)));
+  END_CPP11
+}
+// connection.cpp
 bool connection_is_transacting(DbConnection* con);
 extern "C" SEXP _RPostgres_connection_is_transacting(SEXP con) {
   BEGIN_CPP11
@@ -79,6 +129,147 @@ extern "C" SEXP _RPostgres_connection_copy_data(SEXP con, SEXP sql, SEXP df) {
   END_CPP11
 }
 // connection.cpp
+double connection_copy_to_file(DbConnection* con, std::string sql, std::string path);
+extern "C" SEXP _RPostgres_connection_copy_to_file(SEXP con, SEXP sql, SEXP path) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_copy_to_file(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<std::string>>(sql), cpp11::as_cpp<cpp11::decay_t<std::string>>(path)));
+  END_CPP11
+}
+// connection.cpp
+void connection_insert_values(DbConnection* con, std::string prefix, cpp11::list df, bool redshift, double batch_bytes);
+extern "C" SEXP _RPostgres_connection_insert_values(SEXP con, SEXP prefix, SEXP df, SEXP redshift, SEXP batch_bytes) {
+  BEGIN_CPP11
+    connection_insert_values(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<std::string>>(prefix), cpp11::as_cpp<cpp11::decay_t<cpp11::list>>(df), cpp11::as_cpp<cpp11::decay_t<bool>>(redshift), cpp11::as_cpp<cpp11::decay_t<double>>(batch_bytes));
+    return R_NilValue;
+  END_CPP11
+}
+// connection.cpp
+void connection_copy_data_parallel(cpp11::list cons, std::string sql, cpp11::list df);
+extern "C" SEXP _RPostgres_connection_copy_data_parallel(SEXP cons, SEXP sql, SEXP df) {
+  BEGIN_CPP11
+    connection_copy_data_parallel(cpp11::as_cpp<cpp11::decay_t<cpp11::list>>(cons), cpp11::as_cpp<cpp11::decay_t<std::string>>(sql), cpp11::as_cpp<cpp11::decay_t<cpp11::list>>(df));
+    return R_NilValue;
+  END_CPP11
+}
+// connection.cpp
+void connection_cache_configure(DbConnection* con, double max_bytes, double ttl_secs, std::vector<std::string> channels);
+extern "C" SEXP _RPostgres_connection_cache_configure(SEXP con, SEXP max_bytes, SEXP ttl_secs, SEXP channels) {
+  BEGIN_CPP11
+    connection_cache_configure(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<double>>(max_bytes), cpp11::as_cpp<cpp11::decay_t<double>>(ttl_secs), cpp11::as_cpp<cpp11::decay_t<std::vector<std::string>>>(channels));
+    return R_NilValue;
+  END_CPP11
+}
+// connection.cpp
+bool connection_cache_enabled(DbConnection* con);
+extern "C" SEXP _RPostgres_connection_cache_enabled(SEXP con) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_cache_enabled(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con)));
+  END_CPP11
+}
+// connection.cpp
+cpp11::list connection_cache_info(DbConnection* con);
+extern "C" SEXP _RPostgres_connection_cache_info(SEXP con) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_cache_info(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con)));
+  END_CPP11
+}
+// connection.cpp
+void connection_cache_clear(DbConnection* con);
+extern "C" SEXP _RPostgres_connection_cache_clear(SEXP con) {
+  BEGIN_CPP11
+    connection_cache_clear(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con));
+    return R_NilValue;
+  END_CPP11
+}
+// connection.cpp
+cpp11::sexp connection_cache_get(DbConnection* con, std::string sql, cpp11::list params);
+extern "C" SEXP _RPostgres_connection_cache_get(SEXP con, SEXP sql, SEXP params) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_cache_get(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<std::string>>(sql), cpp11::as_cpp<cpp11::decay_t<cpp11::list>>(params)));
+  END_CPP11
+}
+// connection.cpp
+void connection_cache_put(DbConnection* con, std::string sql, cpp11::list params, cpp11::sexp value);
+extern "C" SEXP _RPostgres_connection_cache_put(SEXP con, SEXP sql, SEXP params, SEXP value) {
+  BEGIN_CPP11
+    connection_cache_put(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<std::string>>(sql), cpp11::as_cpp<cpp11::decay_t<cpp11::list>>(params), cpp11::as_cpp<cpp11::decay_t<cpp11::sexp>>(value));
+    return R_NilValue;
+  END_CPP11
+}
+// connection.cpp
+std::string connection_command_status(DbConnection* con);
+extern "C" SEXP _RPostgres_connection_command_status(SEXP con) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_command_status(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con)));
+  END_CPP11
+}
+// connection.cpp
+void connection_relations_configure(DbConnection* con, bool enabled, std::vector<std::string> channels);
+extern "C" SEXP _RPostgres_connection_relations_configure(SEXP con, SEXP enabled, SEXP channels) {
+  BEGIN_CPP11
+    connection_relations_configure(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<bool>>(enabled), cpp11::as_cpp<cpp11::decay_t<std::vector<std::string>>>(channels));
+    return R_NilValue;
+  END_CPP11
+}
+// connection.cpp
+cpp11::list connection_relations_info(DbConnection* con);
+extern "C" SEXP _RPostgres_connection_relations_info(SEXP con) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_relations_info(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con)));
+  END_CPP11
+}
+// connection.cpp
+cpp11::sexp connection_relations_get(DbConnection* con);
+extern "C" SEXP _RPostgres_connection_relations_get(SEXP con) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_relations_get(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con)));
+  END_CPP11
+}
+// connection.cpp
+void connection_relations_put(DbConnection* con, cpp11::sexp value);
+extern "C" SEXP _RPostgres_connection_relations_put(SEXP con, SEXP value) {
+  BEGIN_CPP11
+    connection_relations_put(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<cpp11::sexp>>(value));
+    return R_NilValue;
+  END_CPP11
+}
+// connection.cpp
+cpp11::sexp connection_lo_read_raw(DbConnection* con, double oid, double offset, double length, double chunk_size);
+extern "C" SEXP _RPostgres_connection_lo_read_raw(SEXP con, SEXP oid, SEXP offset, SEXP length, SEXP chunk_size) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_lo_read_raw(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<double>>(oid), cpp11::as_cpp<cpp11::decay_t<double>>(offset), cpp11::as_cpp<cpp11::decay_t<double>>(length), cpp11::as_cpp<cpp11::decay_t<double>>(chunk_size)));
+  END_CPP11
+}
+// connection.cpp
+double connection_lo_read_file(DbConnection* con, double oid, double offset, double length, double chunk_size, std::string path);
+extern "C" SEXP _RPostgres_connection_lo_read_file(SEXP con, SEXP oid, SEXP offset, SEXP length, SEXP chunk_size, SEXP path) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_lo_read_file(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<double>>(oid), cpp11::as_cpp<cpp11::decay_t<double>>(offset), cpp11::as_cpp<cpp11::decay_t<double>>(length), cpp11::as_cpp<cpp11::decay_t<double>>(chunk_size), cpp11::as_cpp<cpp11::decay_t<std::string>>(path)));
+  END_CPP11
+}
+// connection.cpp
+double connection_lo_write_raw(DbConnection* con, cpp11::raws data, double chunk_size);
+extern "C" SEXP _RPostgres_connection_lo_write_raw(SEXP con, SEXP data, SEXP chunk_size) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_lo_write_raw(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<cpp11::raws>>(data), cpp11::as_cpp<cpp11::decay_t<double>>(chunk_size)));
+  END_CPP11
+}
+// connection.cpp
+double connection_lo_write_file(DbConnection* con, std::string path, double chunk_size);
+extern "C" SEXP _RPostgres_connection_lo_write_file(SEXP con, SEXP path, SEXP chunk_size) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_lo_write_file(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<std::string>>(path), cpp11::as_cpp<cpp11::decay_t<double>>(chunk_size)));
+  END_CPP11
+}
+// connection.cpp
+void connection_lo_unlink(DbConnection* con, double oid);
+extern "C" SEXP _RPostgres_connection_lo_unlink(SEXP con, SEXP oid) {
+  BEGIN_CPP11
+    connection_lo_unlink(cpp11::as_cpp<cpp11::decay_t<DbConnection*>>(con), cpp11::as_cpp<cpp11::decay_t<double>>(oid));
+    return R_NilValue;
+  END_CPP11
+}
+// connection.cpp
 cpp11::list connection_wait_for_notify(DbConnection* con, int timeout_secs);
 extern "C" SEXP _RPostgres_connection_wait_for_notify(SEXP con, SEXP timeout_secs) {
   BEGIN_CPP11
@@ -86,6 +277,13 @@ extern "C" SEXP _RPostgres_connection_wait_for_notify(SEXP con, SEXP timeout_sec
   END_CPP11
 }
 // connection.cpp
+cpp11::list connection_wait_for_notifications(cpp11::list cons, int timeout_ms, int n_max);
+extern "C" SEXP _RPostgres_connection_wait_for_notifications(SEXP cons, SEXP timeout_ms, SEXP n_max) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(connection_wait_for_notifications(cpp11::as_cpp<cpp11::decay_t<cpp11::list>>(cons), cpp11::as_cpp<cpp11::decay_t<int>>(timeout_ms), cpp11::as_cpp<cpp11::decay_t<int>>(n_max)));
+  END_CPP11
+}
+// connection.cpp
 cpp11::strings connection_get_temp_schema(DbConnection* con);
 extern "C" SEXP _RPostgres_connection_get_temp_schema(SEXP con) {
   BEGIN_CPP11
@@ -129,6 +327,102 @@ extern "C" SEXP _RPostgres_init_logging(SEXP log_level) {
     return R_NilValue;
   END_CPP11
 }
+// pool.cpp
+cpp11::external_pointer<DbConnectionPoolPtr> pool_create(std::vector<std::string> keys, std::vector<std::string> values, bool check_interrupts, int interrupt_latency_ms, std::vector<std::string> init_sql, std::string reset_sql, int min_size, int max_size, double idle_timeout, double check_interval);
+extern "C" SEXP _RPostgres_pool_create(SEXP keys, SEXP values, SEXP check_interrupts, SEXP interrupt_latency_ms, SEXP init_sql, SEXP reset_sql, SEXP min_size, SEXP max_size, SEXP idle_timeout, SEXP check_interval) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(pool_create(cpp11::as_cpp<cpp11::decay_t<std::vector<std::string>>>(keys), cpp11::as_cpp<cpp11::decay_t<std::vector<std::string>>>(values), cpp11::as_cpp<cpp11::decay_t<bool>>(check_interrupts), cpp11::as_cpp<cpp11::decay_t<int>>(interrupt_latency_ms), cpp11::as_cpp<cpp11::decay_t<std::vector<std::string>>>(init_sql), cpp11::as_cpp<cpp11::decay_t<std::string>>(reset_sql), cpp11::as_cpp<cpp11::decay_t<int>>(min_size), cpp11::as_cpp<cpp11::decay_t<int>>(max_size), cpp11::as_cpp<cpp11::decay_t<double>>(idle_timeout), cpp11::as_cpp<cpp11::decay_t<double>>(check_interval)));
+  END_CPP11
+}
+// pool.cpp
+bool pool_valid(cpp11::external_pointer<DbConnectionPoolPtr> pool_);
+extern "C" SEXP _RPostgres_pool_valid(SEXP pool_) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(pool_valid(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<DbConnectionPoolPtr>>>(pool_)));
+  END_CPP11
+}
+// pool.cpp
+cpp11::external_pointer<DbConnectionPtr> pool_acquire(DbConnectionPool* pool);
+extern "C" SEXP _RPostgres_pool_acquire(SEXP pool) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(pool_acquire(cpp11::as_cpp<cpp11::decay_t<DbConnectionPool*>>(pool)));
+  END_CPP11
+}
+// pool.cpp
+cpp11::list pool_info(DbConnectionPool* pool);
+extern "C" SEXP _RPostgres_pool_info(SEXP pool) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(pool_info(cpp11::as_cpp<cpp11::decay_t<DbConnectionPool*>>(pool)));
+  END_CPP11
+}
+// pool.cpp
+void pool_close(cpp11::external_pointer<DbConnectionPoolPtr> pool_);
+extern "C" SEXP _RPostgres_pool_close(SEXP pool_) {
+  BEGIN_CPP11
+    pool_close(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<DbConnectionPoolPtr>>>(pool_));
+    return R_NilValue;
+  END_CPP11
+}
+// replication.cpp
+cpp11::external_pointer<PqReplicationPtr> replication_connect(std::vector<std::string> keys, std::vector<std::string> values, bool check_interrupts);
+extern "C" SEXP _RPostgres_replication_connect(SEXP keys, SEXP values, SEXP check_interrupts) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(replication_connect(cpp11::as_cpp<cpp11::decay_t<std::vector<std::string>>>(keys), cpp11::as_cpp<cpp11::decay_t<std::vector<std::string>>>(values), cpp11::as_cpp<cpp11::decay_t<bool>>(check_interrupts)));
+  END_CPP11
+}
+// replication.cpp
+bool replication_valid(cpp11::external_pointer<PqReplicationPtr> stream_);
+extern "C" SEXP _RPostgres_replication_valid(SEXP stream_) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(replication_valid(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<PqReplicationPtr>>>(stream_)));
+  END_CPP11
+}
+// replication.cpp
+void replication_create_slot(PqReplication* stream, std::string slot, bool temporary);
+extern "C" SEXP _RPostgres_replication_create_slot(SEXP stream, SEXP slot, SEXP temporary) {
+  BEGIN_CPP11
+    replication_create_slot(cpp11::as_cpp<cpp11::decay_t<PqReplication*>>(stream), cpp11::as_cpp<cpp11::decay_t<std::string>>(slot), cpp11::as_cpp<cpp11::decay_t<bool>>(temporary));
+    return R_NilValue;
+  END_CPP11
+}
+// replication.cpp
+void replication_start(PqReplication* stream, std::string slot, std::vector<std::string> publications, std::string start_lsn);
+extern "C" SEXP _RPostgres_replication_start(SEXP stream, SEXP slot, SEXP publications, SEXP start_lsn) {
+  BEGIN_CPP11
+    replication_start(cpp11::as_cpp<cpp11::decay_t<PqReplication*>>(stream), cpp11::as_cpp<cpp11::decay_t<std::string>>(slot), cpp11::as_cpp<cpp11::decay_t<std::vector<std::string>>>(publications), cpp11::as_cpp<cpp11::decay_t<std::string>>(start_lsn));
+    return R_NilValue;
+  END_CPP11
+}
+// replication.cpp
+cpp11::list replication_read(PqReplication* stream, int timeout_ms, int max_changes);
+extern "C" SEXP _RPostgres_replication_read(SEXP stream, SEXP timeout_ms, SEXP max_changes) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(replication_read(cpp11::as_cpp<cpp11::decay_t<PqReplication*>>(stream), cpp11::as_cpp<cpp11::decay_t<int>>(timeout_ms), cpp11::as_cpp<cpp11::decay_t<int>>(max_changes)));
+  END_CPP11
+}
+// replication.cpp
+void replication_acknowledge(PqReplication* stream, std::string lsn);
+extern "C" SEXP _RPostgres_replication_acknowledge(SEXP stream, SEXP lsn) {
+  BEGIN_CPP11
+    replication_acknowledge(cpp11::as_cpp<cpp11::decay_t<PqReplication*>>(stream), cpp11::as_cpp<cpp11::decay_t<std::string>>(lsn));
+    return R_NilValue;
+  END_CPP11
+}
+// replication.cpp
+cpp11::list replication_info(PqReplication* stream);
+extern "C" SEXP _RPostgres_replication_info(SEXP stream) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(replication_info(cpp11::as_cpp<cpp11::decay_t<PqReplication*>>(stream)));
+  END_CPP11
+}
+// replication.cpp
+void replication_close(cpp11::external_pointer<PqReplicationPtr> stream_);
+extern "C" SEXP _RPostgres_replication_close(SEXP stream_) {
+  BEGIN_CPP11
+    replication_close(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<PqReplicationPtr>>>(stream_));
+    return R_NilValue;
+  END_CPP11
+}
 // result.cpp
 cpp11::external_pointer<DbResult> result_create(cpp11::external_pointer<DbConnectionPtr> con, std::string sql, bool immediate);
 extern "C" SEXP _RPostgres_result_create(SEXP con, SEXP sql, SEXP immediate) {
@@ -137,6 +431,20 @@ extern "C" SEXP _RPostgres_result_create(SEXP con, SEXP sql, SEXP immediate) {
   END_CPP11
 }
 // result.cpp
+cpp11::external_pointer<DbResult> result_create_async(cpp11::external_pointer<DbConnectionPtr> con, std::string sql, bool immediate);
+extern "C" SEXP _RPostgres_result_create_async(SEXP con, SEXP sql, SEXP immediate) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(result_create_async(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<DbConnectionPtr>>>(con), cpp11::as_cpp<cpp11::decay_t<std::string>>(sql), cpp11::as_cpp<cpp11::decay_t<bool>>(immediate)));
+  END_CPP11
+}
+// result.cpp
+cpp11::external_pointer<DbResult> result_create_cursor(cpp11::external_pointer<DbConnectionPtr> con, std::string sql, int cursor_rows);
+extern "C" SEXP _RPostgres_result_create_cursor(SEXP con, SEXP sql, SEXP cursor_rows) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(result_create_cursor(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<DbConnectionPtr>>>(con), cpp11::as_cpp<cpp11::decay_t<std::string>>(sql), cpp11::as_cpp<cpp11::decay_t<int>>(cursor_rows)));
+  END_CPP11
+}
+// result.cpp
 void result_release(cpp11::external_pointer<DbResult> res);
 extern "C" SEXP _RPostgres_result_release(SEXP res) {
   BEGIN_CPP11
@@ -152,6 +460,14 @@ extern "C" SEXP _RPostgres_result_valid(SEXP res_) {
   END_CPP11
 }
 // result.cpp
+void result_set_prefetch(DbResult* res, double max_bytes);
+extern "C" SEXP _RPostgres_result_set_prefetch(SEXP res, SEXP max_bytes) {
+  BEGIN_CPP11
+    result_set_prefetch(cpp11::as_cpp<cpp11::decay_t<DbResult*>>(res), cpp11::as_cpp<cpp11::decay_t<double>>(max_bytes));
+    return R_NilValue;
+  END_CPP11
+}
+// result.cpp
 cpp11::list result_fetch(DbResult* res, const int n);
 extern "C" SEXP _RPostgres_result_fetch(SEXP res, SEXP n) {
   BEGIN_CPP11
@@ -159,6 +475,13 @@ extern "C" SEXP _RPostgres_result_fetch(SEXP res, SEXP n) {
   END_CPP11
 }
 // result.cpp
+cpp11::list result_fetch_statements(DbResult* res);
+extern "C" SEXP _RPostgres_result_fetch_statements(SEXP res) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(result_fetch_statements(cpp11::as_cpp<cpp11::decay_t<DbResult*>>(res)));
+  END_CPP11
+}
+// result.cpp
 void result_bind(DbResult* res, cpp11::list params);
 extern "C" SEXP _RPostgres_result_bind(SEXP res, SEXP params) {
   BEGIN_CPP11
@@ -194,35 +517,87 @@ extern "C" SEXP _RPostgres_result_column_info(SEXP res) {
     return cpp11::as_sexp(result_column_info(cpp11::as_cpp<cpp11::decay_t<DbResult*>>(res)));
   END_CPP11
 }
+// result.cpp
+cpp11::logicals result_poll(cpp11::list res, int timeout_ms);
+extern "C" SEXP _RPostgres_result_poll(SEXP res, SEXP timeout_ms) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(result_poll(cpp11::as_cpp<cpp11::decay_t<cpp11::list>>(res), cpp11::as_cpp<cpp11::decay_t<int>>(timeout_ms)));
+  END_CPP11
+}
 
 extern "C" {
 static const R_CallMethodDef CallEntries[] = {
-    {"_RPostgres_client_version",              (DL_FUNC) &_RPostgres_client_version,              0},
-    {"_RPostgres_connection_copy_data",        (DL_FUNC) &_RPostgres_connection_copy_data,        3},
-    {"_RPostgres_connection_create",           (DL_FUNC) &_RPostgres_connection_create,           3},
-    {"_RPostgres_connection_get_temp_schema",  (DL_FUNC) &_RPostgres_connection_get_temp_schema,  1},
-    {"_RPostgres_connection_info",             (DL_FUNC) &_RPostgres_connection_info,             1},
-    {"_RPostgres_connection_is_transacting",   (DL_FUNC) &_RPostgres_connection_is_transacting,   1},
-    {"_RPostgres_connection_quote_identifier", (DL_FUNC) &_RPostgres_connection_quote_identifier, 2},
-    {"_RPostgres_connection_quote_string",     (DL_FUNC) &_RPostgres_connection_quote_string,     2},
-    {"_RPostgres_connection_release",          (DL_FUNC) &_RPostgres_connection_release,          1},
-    {"_RPostgres_connection_set_temp_schema",  (DL_FUNC) &_RPostgres_connection_set_temp_schema,  2},
-    {"_RPostgres_connection_set_transacting",  (DL_FUNC) &_RPostgres_connection_set_transacting,  2},
-    {"_RPostgres_connection_valid",            (DL_FUNC) &_RPostgres_connection_valid,            1},
-    {"_RPostgres_connection_wait_for_notify",  (DL_FUNC) &_RPostgres_connection_wait_for_notify,  2},
-    {"_RPostgres_encode_data_frame",           (DL_FUNC) &_RPostgres_encode_data_frame,           1},
-    {"_RPostgres_encode_vector",               (DL_FUNC) &_RPostgres_encode_vector,               1},
-    {"_RPostgres_encrypt_password",            (DL_FUNC) &_RPostgres_encrypt_password,            2},
-    {"_RPostgres_init_logging",                (DL_FUNC) &_RPostgres_init_logging,                1},
-    {"_RPostgres_result_bind",                 (DL_FUNC) &_RPostgres_result_bind,                 2},
-    {"_RPostgres_result_column_info",          (DL_FUNC) &_RPostgres_result_column_info,          1},
-    {"_RPostgres_result_create",               (DL_FUNC) &_RPostgres_result_create,               3},
-    {"_RPostgres_result_fetch",                (DL_FUNC) &_RPostgres_result_fetch,                2},
-    {"_RPostgres_result_has_completed",        (DL_FUNC) &_RPostgres_result_has_completed,        1},
-    {"_RPostgres_result_release",              (DL_FUNC) &_RPostgres_result_release,              1},
-    {"_RPostgres_result_rows_affected",        (DL_FUNC) &_RPostgres_result_rows_affected,        1},
-    {"_RPostgres_result_rows_fetched",         (DL_FUNC) &_RPostgres_result_rows_fetched,         1},
-    {"_RPostgres_result_valid",                (DL_FUNC) &_RPostgres_result_valid,                1},
+    {"_RPostgres_client_version",                    (DL_FUNC) &_RPostgres_client_version,                    0},
+    {"_RPostgres_connection_cache_clear",            (DL_FUNC) &_RPostgres_connection_cache_clear,            1},
+    {"_RPostgres_connection_cache_configure",        (DL_FUNC) &_RPostgres_connection_cache_configure,        4},
+    {"_RPostgres_connection_cache_enabled",          (DL_FUNC) &_RPostgres_connection_cache_enabled,          1},
+    {"_RPostgres_connection_cache_get",              (DL_FUNC) &_RPostgres_connection_cache_get,              3},
+    {"_RPostgres_connection_cache_info",             (DL_FUNC) &_RPostgres_connection_cache_info,             1},
+    {"_RPostgres_connection_cache_put",              (DL_FUNC) &_RPostgres_connection_cache_put,              4},
+    {"_RPostgres_connection_command_status",         (DL_FUNC) &_RPostgres_connection_command_status,         1},
+    {"_RPostgres_connection_conninfo",               (DL_FUNC) &_RPostgres_connection_conninfo,               1},
+    {"_RPostgres_connection_copy_data",              (DL_FUNC) &_RPostgres_connection_copy_data,              3},
+    {"_RPostgres_connection_copy_data_parallel",     (DL_FUNC) &_RPostgres_connection_copy_data_parallel,     3},
+    {"_RPostgres_connection_copy_to_file",           (DL_FUNC) &_RPostgres_connection_copy_to_file,           3},
+    {"_RPostgres_connection_create",                 (DL_FUNC) &_RPostgres_connection_create,                 3},
+    {"_RPostgres_connection_create_many",            (DL_FUNC) &_RPostgres_connection_create_many,            6},
+    {"_RPostgres_connection_get_check_interrupts",   (DL_FUNC) &_RPostgres_connection_get_check_interrupts,   1},
+    {"_RPostgres_connection_get_temp_schema",        (DL_FUNC) &_RPostgres_connection_get_temp_schema,        1},
+    {"_RPostgres_connection_info",                   (DL_FUNC) &_RPostgres_connection_info,                   1},
+    {"_RPostgres_connection_insert_values",          (DL_FUNC) &_RPostgres_connection_insert_values,          5},
+    {"_RPostgres_connection_is_transacting",         (DL_FUNC) &_RPostgres_connection_is_transacting,         1},
+    {"_RPostgres_connection_lo_read_file",           (DL_FUNC) &_RPostgres_connection_lo_read_file,           6},
+    {"_RPostgres_connection_lo_read_raw",            (DL_FUNC) &_RPostgres_connection_lo_read_raw,            5},
+    {"_RPostgres_connection_lo_unlink",              (DL_FUNC) &_RPostgres_connection_lo_unlink,              2},
+    {"_RPostgres_connection_lo_write_file",          (DL_FUNC) &_RPostgres_connection_lo_write_file,          3},
+    {"_RPostgres_connection_lo_write_raw",           (DL_FUNC) &_RPostgres_connection_lo_write_raw,           3},
+    {"_RPostgres_connection_parameter_status",       (DL_FUNC) &_RPostgres_connection_parameter_status,       2},
+    {"_RPostgres_connection_quote_identifier",       (DL_FUNC) &_RPostgres_connection_quote_identifier,       2},
+    {"_RPostgres_connection_quote_literal",          (DL_FUNC) &_RPostgres_connection_quote_literal,          3},
+    {"_RPostgres_connection_quote_string",           (DL_FUNC) &_RPostgres_connection_quote_string,           3},
+    {"_RPostgres_connection_relations_configure",    (DL_FUNC) &_RPostgres_connection_relations_configure,    3},
+    {"_RPostgres_connection_relations_get",          (DL_FUNC) &_RPostgres_connection_relations_get,          1},
+    {"_RPostgres_connection_relations_info",         (DL_FUNC) &_RPostgres_connection_relations_info,         1},
+    {"_RPostgres_connection_relations_put",          (DL_FUNC) &_RPostgres_connection_relations_put,          2},
+    {"_RPostgres_connection_release",                (DL_FUNC) &_RPostgres_connection_release,                1},
+    {"_RPostgres_connection_set_interrupt_latency",  (DL_FUNC) &_RPostgres_connection_set_interrupt_latency,  2},
+    {"_RPostgres_connection_set_temp_schema",        (DL_FUNC) &_RPostgres_connection_set_temp_schema,        2},
+    {"_RPostgres_connection_set_transacting",        (DL_FUNC) &_RPostgres_connection_set_transacting,        2},
+    {"_RPostgres_connection_typnames",               (DL_FUNC) &_RPostgres_connection_typnames,               2},
+    {"_RPostgres_connection_valid",                  (DL_FUNC) &_RPostgres_connection_valid,                  1},
+    {"_RPostgres_connection_wait_for_notifications", (DL_FUNC) &_RPostgres_connection_wait_for_notifications, 3},
+    {"_RPostgres_connection_wait_for_notify",        (DL_FUNC) &_RPostgres_connection_wait_for_notify,        2},
+    {"_RPostgres_encode_data_frame",                 (DL_FUNC) &_RPostgres_encode_data_frame,                 1},
+    {"_RPostgres_encode_vector",                     (DL_FUNC) &_RPostgres_encode_vector,                     1},
+    {"_RPostgres_encrypt_password",                  (DL_FUNC) &_RPostgres_encrypt_password,                  2},
+    {"_RPostgres_init_logging",                      (DL_FUNC) &_RPostgres_init_logging,                      1},
+    {"_RPostgres_pool_acquire",                      (DL_FUNC) &_RPostgres_pool_acquire,                      1},
+    {"_RPostgres_pool_close",                        (DL_FUNC) &_RPostgres_pool_close,                        1},
+    {"_RPostgres_pool_create",                       (DL_FUNC) &_RPostgres_pool_create,                       10},
+    {"_RPostgres_pool_info",                         (DL_FUNC) &_RPostgres_pool_info,                         1},
+    {"_RPostgres_pool_valid",                        (DL_FUNC) &_RPostgres_pool_valid,                        1},
+    {"_RPostgres_replication_acknowledge",           (DL_FUNC) &_RPostgres_replication_acknowledge,           2},
+    {"_RPostgres_replication_close",                 (DL_FUNC) &_RPostgres_replication_close,                 1},
+    {"_RPostgres_replication_connect",               (DL_FUNC) &_RPostgres_replication_connect,               3},
+    {"_RPostgres_replication_create_slot",           (DL_FUNC) &_RPostgres_replication_create_slot,           3},
+    {"_RPostgres_replication_info",                  (DL_FUNC) &_RPostgres_replication_info,                  1},
+    {"_RPostgres_replication_read",                  (DL_FUNC) &_RPostgres_replication_read,                  3},
+    {"_RPostgres_replication_start",                 (DL_FUNC) &_RPostgres_replication_start,                 4},
+    {"_RPostgres_replication_valid",                 (DL_FUNC) &_RPostgres_replication_valid,                 1},
+    {"_RPostgres_result_bind",                       (DL_FUNC) &_RPostgres_result_bind,                       2},
+    {"_RPostgres_result_column_info",                (DL_FUNC) &_RPostgres_result_column_info,                1},
+    {"_RPostgres_result_create",                     (DL_FUNC) &_RPostgres_result_create,                     3},
+    {"_RPostgres_result_create_async",               (DL_FUNC) &_RPostgres_result_create_async,               3},
+    {"_RPostgres_result_create_cursor",              (DL_FUNC) &_RPostgres_result_create_cursor,              3},
+    {"_RPostgres_result_fetch",                      (DL_FUNC) &_RPostgres_result_fetch,                      2},
+    {"_RPostgres_result_fetch_statements",           (DL_FUNC) &_RPostgres_result_fetch_statements,           1},
+    {"_RPostgres_result_has_completed",              (DL_FUNC) &_RPostgres_result_has_completed,              1},
+    {"_RPostgres_result_poll",                       (DL_FUNC) &_RPostgres_result_poll,                       2},
+    {"_RPostgres_result_release",                    (DL_FUNC) &_RPostgres_result_release,                    1},
+    {"_RPostgres_result_rows_affected",              (DL_FUNC) &_RPostgres_result_rows_affected,              1},
+    {"_RPostgres_result_rows_fetched",               (DL_FUNC) &_RPostgres_result_rows_fetched,               1},
+    {"_RPostgres_result_set_prefetch",               (DL_FUNC) &_RPostgres_result_set_prefetch,               2},
+    {"_RPostgres_result_valid",                      (DL_FUNC) &_RPostgres_result_valid,                      1},
     {NULL, NULL, 0}
 };
 }
@@ -0,0 +1,55 @@
+#include "pch.h"
+#include "RPostgres_types.h"
+#include "DbConnectionPool.h"
+
+
+[[cpp11::register]]
+cpp11::external_pointer<DbConnectionPoolPtr> pool_create(
+  std::vector<std::string> keys,
+  std::vector<std::string> values,
+  bool check_interrupts,
+  int interrupt_latency_ms,
+  std::vector<std::string> init_sql,
+  std::string reset_sql,
+  int min_size,
+  int max_size,
+  double idle_timeout,
+  double check_interval
+) {
+  LOG_VERBOSE;
+
+  DbConnectionPoolPtr* pPool = new DbConnectionPoolPtr(
+    new DbConnectionPool(keys, values, check_interrupts, interrupt_latency_ms, init_sql, reset_sql,
+                         min_size, max_size, idle_timeout, check_interval)
+  );
+
+  return cpp11::external_pointer<DbConnectionPoolPtr>(pPool, true);
+}
+
+[[cpp11::register]]
+bool pool_valid(cpp11::external_pointer<DbConnectionPoolPtr> pool_) {
+  DbConnectionPoolPtr* pool = pool_.get();
+  return pool;
+}
+
+[[cpp11::register]]
+cpp11::external_pointer<DbConnectionPtr> pool_acquire(DbConnectionPool* pool) {
+  DbConnectionPtr* pConn = new DbConnectionPtr(pool->acquire());
+  return cpp11::external_pointer<DbConnectionPtr>(pConn, true);
+}
+
+[[cpp11::register]]
+cpp11::list pool_info(DbConnectionPool* pool) {
+  return pool->info();
+}
+
+[[cpp11::register]]
+void pool_close(cpp11::external_pointer<DbConnectionPoolPtr> pool_) {
+  if (!pool_valid(pool_)) {
+    cpp11::warning(std::string("Pool already closed"));
+    return;
+  }
+
+  pool_->get()->close();
+  pool_.reset();
+}
@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "RPostgres_types.h"
+#include "PqReplication.h"
+
+
+[[cpp11::register]]
+cpp11::external_pointer<PqReplicationPtr> replication_connect(
+  std::vector<std::string> keys,
+  std::vector<std::string> values,
+  bool check_interrupts
+) {
+  LOG_VERBOSE;
+
+  PqReplicationPtr* pStream = new PqReplicationPtr(
+    new PqReplication(keys, values, check_interrupts)
+  );
+
+  return cpp11::external_pointer<PqReplicationPtr>(pStream, true);
+}
+
+[[cpp11::register]]
+bool replication_valid(cpp11::external_pointer<PqReplicationPtr> stream_) {
+  PqReplicationPtr* stream = stream_.get();
+  return stream;
+}
+
+[[cpp11::register]]
+void replication_create_slot(PqReplication* stream, std::string slot, bool temporary) {
+  stream->create_slot(slot, temporary);
+}
+
+[[cpp11::register]]
+void replication_start(PqReplication* stream, std::string slot, std::vector<std::string> publications,
+                       std::string start_lsn) {
+  stream->start(slot, publications, start_lsn);
+}
+
+[[cpp11::register]]
+cpp11::list replication_read(PqReplication* stream, int timeout_ms, int max_changes) {
+  return stream->read(timeout_ms, max_changes);
+}
+
+[[cpp11::register]]
+void replication_acknowledge(PqReplication* stream, std::string lsn) {
+  stream->acknowledge(PqReplication::parse_lsn(lsn));
+}
+
+[[cpp11::register]]
+cpp11::list replication_info(PqReplication* stream) {
+  return stream->info();
+}
+
+[[cpp11::register]]
+void replication_close(cpp11::external_pointer<PqReplicationPtr> stream_) {
+  if (!replication_valid(stream_)) {
+    cpp11::warning(std::string("Replication stream already closed"));
+    return;
+  }
+
+  stream_->get()->stop();
+  stream_.reset();
+}
@@ -1,6 +1,9 @@
 #include "pch.h"
 #include "RPostgres_types.h"
 #include "PqResult.h"
+#include "PqPoll.h"
+
+#include <chrono>
 
 
 [[cpp11::register]]
@@ -10,6 +13,20 @@ cpp11::external_pointer<DbResult> result_create(cpp11::external_pointer<DbConnec
   return cpp11::external_pointer<DbResult>(res, true);
 }
 
+[[cpp11::register]]
+cpp11::external_pointer<DbResult> result_create_async(cpp11::external_pointer<DbConnectionPtr> con, std::string sql, bool immediate) {
+  (*con)->check_connection();
+  DbResult* res = PqResult::create_async(*con, sql, immediate);
+  return cpp11::external_pointer<DbResult>(res, true);
+}
+
+[[cpp11::register]]
+cpp11::external_pointer<DbResult> result_create_cursor(cpp11::external_pointer<DbConnectionPtr> con, std::string sql, int cursor_rows) {
+  (*con)->check_connection();
+  DbResult* res = PqResult::create_cursor(*con, sql, cursor_rows);
+  return cpp11::external_pointer<DbResult>(res, true);
+}
+
 [[cpp11::register]]
 void result_release(cpp11::external_pointer<DbResult> res) {
   res.reset();
@@ -21,11 +38,21 @@ bool result_valid(cpp11::external_pointer<DbResult> res_) {
   return res != NULL && res->is_active();
 }
 
+[[cpp11::register]]
+void result_set_prefetch(DbResult* res, double max_bytes) {
+  res->set_prefetch(static_cast<size_t>(max_bytes));
+}
+
 [[cpp11::register]]
 cpp11::list result_fetch(DbResult* res, const int n) {
   return res->fetch(n);
 }
 
+[[cpp11::register]]
+cpp11::list result_fetch_statements(DbResult* res) {
+  return res->fetch_statements();
+}
+
 [[cpp11::register]]
 void result_bind(DbResult* res, cpp11::list params) {
   res->bind(params);
@@ -50,3 +77,50 @@ int result_rows_affected(DbResult* res) {
 cpp11::list result_column_info(DbResult* res) {
   return res->get_column_info();
 }
+
+// Waits until at least one of the asynchronous queries is ready,
+// or until the timeout expires
+[[cpp11::register]]
+cpp11::logicals result_poll(cpp11::list res, int timeout_ms) {
+  typedef std::chrono::steady_clock clock;
+
+  std::vector<DbResult*> results;
+  results.reserve(res.size());
+  for (R_xlen_t i = 0; i < res.size(); ++i) {
+    results.push_back(cpp11::as_cpp<DbResult*>(res[i]));
+  }
+
+  cpp11::writable::logicals ready(res.size());
+  const clock::time_point start = clock::now();
+
+  for (;;) {
+    bool any_ready = false;
+    std::vector<int> sockets;
+    for (size_t i = 0; i < results.size(); ++i) {
+      bool is_ready = results[i]->is_ready();
+      ready[i] = is_ready;
+      if (is_ready)
+        any_ready = true;
+      else
+        sockets.push_back(results[i]->get_socket());
+    }
+
+    if (any_ready || sockets.empty())
+      break;
+
+    int remaining = timeout_ms;
+    if (timeout_ms >= 0) {
+      int elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+      if (elapsed >= timeout_ms)
+        break;
+      remaining = timeout_ms - elapsed;
+    }
+
+    // A readable socket doesn't guarantee a complete result, check again
+    std::vector<bool> readable;
+    if (pq_poll_sockets(sockets, readable, remaining) == 0)
+      break;
+  }
+
+  return ready;
+}